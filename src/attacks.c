@@ -19,13 +19,10 @@
 #include <assert.h>
 #include <stdint.h>
 
-#ifdef USE_PEXT
-#include <immintrin.h>
-#endif
-
 #include "attacks.h"
 #include "bitboards.h"
 #include "board.h"
+#include "cpu.h"
 #include "types.h"
 
 ALIGN64 uint64_t PawnAttacks[COLOUR_NB][SQUARE_NB];
@@ -37,6 +34,14 @@ ALIGN64 uint64_t KingAttacks[SQUARE_NB];
 ALIGN64 Magic BishopTable[SQUARE_NB];
 ALIGN64 Magic RookTable[SQUARE_NB];
 
+#if defined(USE_COMPACT_SLIDERS)
+ALIGN64 uint16_t BishopPacked[0x1480];
+ALIGN64 uint16_t RookPacked[0x19000];
+#endif
+
+static const int BishopDelta[4][2] = {{-1,-1}, {-1, 1}, { 1,-1}, { 1, 1}};
+static const int RookDelta[4][2]   = {{-1, 0}, { 0,-1}, { 0, 1}, { 1, 0}};
+
 static int validCoordinate(int rank, int file) {
     return 0 <= rank && rank < RANK_NB
         && 0 <= file && file < FILE_NB;
@@ -48,8 +53,11 @@ static void setSquare(uint64_t *bb, int rank, int file) {
 }
 
 static int sliderIndex(uint64_t occupied, Magic *table) {
-#ifdef USE_PEXT
-    return _pext_u64(occupied, table->mask);
+#if defined(USE_PEXT)
+    return pext64(occupied, table->mask);
+#elif defined(__x86_64__)
+    return SliderPext ? pext64(occupied, table->mask)
+         : ((occupied & table->mask) * table->magic) >> table->shift;
 #else
     return ((occupied & table->mask) * table->magic) >> table->shift;
 #endif
@@ -74,13 +82,37 @@ static uint64_t sliderAttacks(int sq, uint64_t occupied, const int delta[4][2])
     return result;
 }
 
+static void initFullSliderAttacks(int sq, Magic *table, const int delta[4][2]) {
+
+    uint64_t occupied = 0ull;
+
+    do { // Init attacks for all occupancy variations
+        int index = sliderIndex(occupied, &table[sq]);
+        table[sq].offset[index] = sliderAttacks(sq, occupied, delta);
+        occupied = (occupied - table[sq].mask) & table[sq].mask;
+    } while (occupied);
+}
+
+#if defined(USE_COMPACT_SLIDERS)
+
+static void initCompactSliderAttacks(int sq, Magic *table, const int delta[4][2]) {
+
+    uint64_t occupied = 0ull;
+
+    do { // Init packed attacks for all occupancy variations
+        int index = pext64(occupied, table[sq].mask);
+        table[sq].packed[index] = pext64(sliderAttacks(sq, occupied, delta), table[sq].rays);
+        occupied = (occupied - table[sq].mask) & table[sq].mask;
+    } while (occupied);
+}
+
+#endif
+
 static void initSliderAttacks(int sq, Magic *table, uint64_t magic, const int delta[4][2]) {
 
     uint64_t edges = ((RANK_1 | RANK_8) & ~Ranks[rankOf(sq)])
                    | ((FILE_A | FILE_H) & ~Files[fileOf(sq)]);
 
-    uint64_t occupied = 0ull;
-
     // Init entry for the given square
     table[sq].magic = magic;
     table[sq].mask  = sliderAttacks(sq, 0, delta) & ~edges;
@@ -90,11 +122,25 @@ static void initSliderAttacks(int sq, Magic *table, uint64_t magic, const int de
     if (sq != SQUARE_NB - 1)
         table[sq+1].offset = table[sq].offset + (1 << popcount(table[sq].mask));
 
-    do { // Init attacks for all occupancy variations
-        int index = sliderIndex(occupied, &table[sq]);
-        table[sq].offset[index] = sliderAttacks(sq, occupied, delta);
-        occupied = (occupied - table[sq].mask) & table[sq].mask;
-    } while (occupied);
+#if defined(USE_COMPACT_SLIDERS)
+
+    // With PEXT, each attack set is instead stored as the 16 bits selected
+    // from every square the slider could ever reach, which PDEP restores.
+    // This is a quarter of the size, and hopefully stays within the L2
+
+    table[sq].rays = sliderAttacks(sq, 0, delta);
+
+    if (sq != SQUARE_NB - 1)
+        table[sq+1].packed = table[sq].packed + (1 << popcount(table[sq].mask));
+
+    if (SliderPext) {
+        initCompactSliderAttacks(sq, table, delta);
+        return;
+    }
+
+#endif
+
+    initFullSliderAttacks(sq, table, delta);
 }
 
 
@@ -103,13 +149,16 @@ void initAttacks() {
     const int PawnDelta[2][2]   = {{ 1,-1}, { 1, 1}};
     const int KnightDelta[8][2] = {{-2,-1}, {-2, 1}, {-1,-2}, {-1, 2},{ 1,-2}, { 1, 2}, { 2,-1}, { 2, 1}};
     const int KingDelta[8][2]   = {{-1,-1}, {-1, 0}, {-1, 1}, { 0,-1},{ 0, 1}, { 1,-1}, { 1, 0}, { 1, 1}};
-    const int BishopDelta[4][2] = {{-1,-1}, {-1, 1}, { 1,-1}, { 1, 1}};
-    const int RookDelta[4][2]   = {{-1, 0}, { 0,-1}, { 0, 1}, { 1, 0}};
 
     // First square has initial offset
     BishopTable[0].offset = BishopAttacks;
     RookTable[0].offset = RookAttacks;
 
+#if defined(USE_COMPACT_SLIDERS)
+    BishopTable[0].packed = BishopPacked;
+    RookTable[0].packed = RookPacked;
+#endif
+
     // Init attack tables for Pawns
     for (int sq = 0; sq < 64; sq++) {
         for (int dir = 0; dir < 2; dir++) {
@@ -133,6 +182,32 @@ void initAttacks() {
     }
 }
 
+#if defined(USE_COMPACT_SLIDERS)
+
+int initAllSliderAttacks() {
+
+    // initAttacks() only fills the tables which will be used. Fill the others
+    // as well, so that slidercheck may compare the two. The compact tables
+    // are indexed with PEXT, so they are never built on hosts without BMI2
+
+    if (!(CPUFeatures & CPU_BMI2))
+        return 0;
+
+    for (int sq = 0; sq < SQUARE_NB; sq++) {
+        if (SliderPext) {
+            initFullSliderAttacks(sq, BishopTable, BishopDelta);
+            initFullSliderAttacks(sq,   RookTable,   RookDelta);
+        } else {
+            initCompactSliderAttacks(sq, BishopTable, BishopDelta);
+            initCompactSliderAttacks(sq,   RookTable,   RookDelta);
+        }
+    }
+
+    return 1;
+}
+
+#endif
+
 uint64_t pawnAttacks(int colour, int sq) {
     assert(0 <= colour && colour < COLOUR_NB);
     assert(0 <= sq && sq < SQUARE_NB);
@@ -146,14 +221,44 @@ uint64_t knightAttacks(int sq) {
 
 uint64_t bishopAttacks(int sq, uint64_t occupied) {
     assert(0 <= sq && sq < SQUARE_NB);
+#if defined(USE_COMPACT_SLIDERS)
+    if (SliderPext) return pdep64(BishopTable[sq].packed[pext64(occupied, BishopTable[sq].mask)], BishopTable[sq].rays);
+#endif
     return BishopTable[sq].offset[sliderIndex(occupied, &BishopTable[sq])];
 }
 
 uint64_t rookAttacks(int sq, uint64_t occupied) {
     assert(0 <= sq && sq < SQUARE_NB);
+#if defined(USE_COMPACT_SLIDERS)
+    if (SliderPext) return pdep64(RookTable[sq].packed[pext64(occupied, RookTable[sq].mask)], RookTable[sq].rays);
+#endif
+    return RookTable[sq].offset[sliderIndex(occupied, &RookTable[sq])];
+}
+
+#if defined(USE_COMPACT_SLIDERS)
+
+uint64_t bishopAttacksFull(int sq, uint64_t occupied) {
+    assert(0 <= sq && sq < SQUARE_NB);
+    return BishopTable[sq].offset[sliderIndex(occupied, &BishopTable[sq])];
+}
+
+uint64_t rookAttacksFull(int sq, uint64_t occupied) {
+    assert(0 <= sq && sq < SQUARE_NB);
     return RookTable[sq].offset[sliderIndex(occupied, &RookTable[sq])];
 }
 
+uint64_t bishopAttacksCompact(int sq, uint64_t occupied) {
+    assert(0 <= sq && sq < SQUARE_NB);
+    return pdep64(BishopTable[sq].packed[pext64(occupied, BishopTable[sq].mask)], BishopTable[sq].rays);
+}
+
+uint64_t rookAttacksCompact(int sq, uint64_t occupied) {
+    assert(0 <= sq && sq < SQUARE_NB);
+    return pdep64(RookTable[sq].packed[pext64(occupied, RookTable[sq].mask)], RookTable[sq].rays);
+}
+
+#endif
+
 uint64_t queenAttacks(int sq, uint64_t occupied) {
     assert(0 <= sq && sq < SQUARE_NB);
     return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
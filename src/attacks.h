@@ -27,6 +27,10 @@ struct Magic {
     uint64_t mask;
     uint64_t shift;
     uint64_t *offset;
+#if defined(USE_COMPACT_SLIDERS)
+    uint64_t rays;
+    uint16_t *packed;
+#endif
 };
 
 void initAttacks();
@@ -38,6 +42,14 @@ uint64_t rookAttacks(int sq, uint64_t occupied);
 uint64_t queenAttacks(int sq, uint64_t occupied);
 uint64_t kingAttacks(int sq);
 
+#if defined(USE_COMPACT_SLIDERS)
+int initAllSliderAttacks();
+uint64_t bishopAttacksFull(int sq, uint64_t occupied);
+uint64_t rookAttacksFull(int sq, uint64_t occupied);
+uint64_t bishopAttacksCompact(int sq, uint64_t occupied);
+uint64_t rookAttacksCompact(int sq, uint64_t occupied);
+#endif
+
 uint64_t pawnLeftAttacks(uint64_t pawns, uint64_t targets, int colour);
 uint64_t pawnRightAttacks(uint64_t pawns, uint64_t targets, int colour);
 uint64_t pawnAttackSpan(uint64_t pawns, uint64_t targets, int colour);
@@ -319,6 +319,44 @@ int boardDrawnByRepetition(Board *board, int height) {
     return 0;
 }
 
+int boardHasUpcomingCycle(Board *board, int height) {
+
+    // Determine if the side to move has a reversible move which reaches an
+    // earlier position in the game or search, using the Cuckoo tables built
+    // alongside the Zobrist keys. Such positions can always be held to a draw
+
+    const uint64_t occupied = board->colours[WHITE] | board->colours[BLACK];
+    const int end = MIN(board->halfMoveCounter, board->numMoves);
+
+    for (int i = 3; i <= end; i += 2) {
+
+        // Only a single piece of either colour may have changed squares
+        uint64_t key = board->hash ^ board->history[board->numMoves - i];
+        unsigned index = CuckooHash1(key);
+
+        if (CuckooKeys[index] != key && CuckooKeys[index = CuckooHash2(key)] != key)
+            continue;
+
+        // And that piece must have a clear path between the two squares
+        int sq1 = MoveFrom(CuckooMoves[index]), sq2 = MoveTo(CuckooMoves[index]);
+        if (bitsBetweenMasks(sq1, sq2) & occupied) continue;
+
+        // The earlier position lies after the root, so a two-fold is sufficient
+        if (i < height) return 1;
+
+        // Otherwise the moving piece must be our own, and the earlier position
+        // must already be a repetition, matching the rules in boardDrawnByRepetition()
+        int sq = board->squares[sq1] == EMPTY ? sq2 : sq1;
+        if (pieceColour(board->squares[sq]) != board->turn) continue;
+
+        for (int j = board->numMoves - i - 4; j >= board->numMoves - end; j -= 2)
+            if (board->history[j] == board->history[board->numMoves - i])
+                return 1;
+    }
+
+    return 0;
+}
+
 int boardDrawnByInsufficientMaterial(Board *board) {
 
     // Check for KvK, KvN, KvB, and KvNN.
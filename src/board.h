@@ -45,6 +45,7 @@ int boardHasNonPawnMaterial(Board *board, int turn);
 int boardIsDrawn(Board *board, int height);
 int boardDrawnByFiftyMoveRule(Board *board);
 int boardDrawnByRepetition(Board *board, int height);
+int boardHasUpcomingCycle(Board *board, int height);
 int boardDrawnByInsufficientMaterial(Board *board);
 
 uint64_t perft(Board *board, int depth);
@@ -16,39 +16,96 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "attacks.h"
+#include "bitboards.h"
 #include "board.h"
 #include "cmdline.h"
+#include "cpu.h"
+#include "datagen.h"
+#include "evalprof.h"
+#include "evaluate.h"
+#include "masks.h"
 #include "move.h"
+#include "movegen.h"
+#include "perfcounters.h"
 #include "search.h"
+#include "searchtrace.h"
 #include "thread.h"
 #include "time.h"
 #include "transposition.h"
 #include "tuner.h"
 #include "uci.h"
+#include "zobrist.h"
 
 void handleCommandLine(int argc, char **argv) {
 
     // Benchmarker is being run from the command line
-    // USAGE: ./Ethereal bench <depth> <threads> <hash>
+    // USAGE: ./Ethereal bench <depth> <threads> <hash> <perf>
     if (argc > 1 && strEquals(argv[1], "bench")) {
         runBenchmark(argc, argv);
         exit(EXIT_SUCCESS);
     }
 
-    // Bench is being run from the command line
-    // USAGE: ./Ethereal evalbook <book> <depth> <threads> <hash>
+    // Book is being searched from the command line
+    // USAGE: ./Ethereal evalbook <book> <depth> <threads> <hash> <nodes> <output>
     if (argc > 2 && strEquals(argv[1], "evalbook")) {
         runEvalBook(argc, argv);
         exit(EXIT_SUCCESS);
     }
 
+    // Self-play training data is being generated from the command line
+    // USAGE: ./Ethereal datagen <games> <threads> <nodes> <output> <hash> <syzygy>
+    if (argc > 2 && strEquals(argv[1], "datagen")) {
+        runDataGen(argc, argv);
+        exit(EXIT_SUCCESS);
+    }
+
+    // Positions are being resolved to quiet qsearch leaves from the command line
+    // USAGE: ./Ethereal quiet <input> <output> <threads> <hash>
+    if (argc > 3 && strEquals(argv[1], "quiet")) {
+        runDataQuiet(argc, argv);
+        exit(EXIT_SUCCESS);
+    }
+
+    // Evaluation profiler is being run from the command line
+    // USAGE: ./Ethereal evalprof <book> <passes>
+    if (argc > 2 && strEquals(argv[1], "evalprof")) {
+        runEvalProfile(argc, argv);
+        exit(EXIT_SUCCESS);
+    }
+
+    // Move validation is being checked and timed from the command line
+    // USAGE: ./Ethereal movecheck <samples> <plies>
+    if (argc > 1 && strEquals(argv[1], "movecheck")) {
+        runMoveCheck(argc, argv);
+        exit(EXIT_SUCCESS);
+    }
+
+    // Slider lookups are being checked and timed from the command line
+    // USAGE: ./Ethereal slidercheck <samples>
+    if (argc > 1 && strEquals(argv[1], "slidercheck")) {
+        runSliderCheck(argc, argv);
+        exit(EXIT_SUCCESS);
+    }
+
+    // Search Trace summary is being run from the command line
+    // USAGE: ./Ethereal readtrace <file>
+    if (argc > 2 && strEquals(argv[1], "readtrace")) {
+        summarizeSearchTrace(argv[2]);
+        exit(EXIT_SUCCESS);
+    }
+
     // Tuner is being run from the command line
+    // USAGE: ./Ethereal [fitk]
     #ifdef TUNE
-        runTuner();
+        runTuner(argc > 1 && strEquals(argv[1], "fitk"));
         exit(EXIT_SUCCESS);
     #endif
 }
@@ -63,12 +120,14 @@ void runBenchmark(int argc, char **argv) {
     Board board;
     Thread *threads;
     Limits limits = {0};
+    PerfCounters counters;
 
     int scores[256];
     double times[256];
     uint64_t nodes[256];
     uint16_t bestMoves[256];
     uint16_t ponderMoves[256];
+    uint64_t events[256][PERF_COUNTER_NB];
 
     double time;
     uint64_t totalNodes = 0ull;
@@ -76,6 +135,13 @@ void runBenchmark(int argc, char **argv) {
     int depth     = argc > 2 ? atoi(argv[2]) : 13;
     int nthreads  = argc > 3 ? atoi(argv[3]) :  1;
     int megabytes = argc > 4 ? atoi(argv[4]) : 16;
+    int perf      = argc > 5 && strEquals(argv[5], "perf");
+
+    // Hardware counters are optional, and may be refused by the kernel
+    if (perf && !initPerfCounters(&counters)) {
+        printf("Unable to open any hardware counters, check perf_event_paranoid\n");
+        freePerfCounters(&counters), perf = 0;
+    }
 
     initTT(megabytes);
     time = getRealTime();
@@ -91,7 +157,9 @@ void runBenchmark(int argc, char **argv) {
         // Perform the search on the position
         limits.start = getRealTime();
         boardFromFEN(&board, Benchmarks[i], 0);
+        if (perf) startPerfCounters(&counters);
         getBestMove(threads, &board, &limits, &bestMoves[i], &ponderMoves[i]);
+        if (perf) stopPerfCounters(&counters, events[i]);
 
         // Stat collection for later printing
         scores[i] = threads->info->values[depth];
@@ -122,36 +190,623 @@ void runBenchmark(int argc, char **argv) {
     for (int i = 0; strcmp(Benchmarks[i], ""); i++) totalNodes += nodes[i];
     printf("OVERALL: %53d nodes %8d nps\n", (int)totalNodes, (int)(1000.0f * totalNodes / (time + 1)));
 
-    free(threads);
+    if (PROFILE) reportEvalProfile();
+
+    if (perf) {
+        reportBenchPerfCounters(Benchmarks, events, nodes);
+        freePerfCounters(&counters);
+    }
+
+    deleteThreadPool(threads);
+}
+
+static void printPerKilonode(uint64_t value, uint64_t nodes) {
+
+    if (value == PERF_UNAVAILABLE)
+        printf(" %12s", "n/a");
+    else
+        printf(" %12.1f", 1000.0 * value / MAX(1ull, nodes));
+}
+
+void reportBenchPerfCounters(const char **benchmarks, uint64_t events[][PERF_COUNTER_NB], uint64_t *nodes) {
+
+    // Report each hardware counter per thousand nodes searched, which
+    // gives a measure of cost that is independent of the search length
+
+    uint64_t totals[PERF_COUNTER_NB] = {0}, totalNodes = 0ull;
+
+    printf("\nHardware counters per kilonode\n");
+    printf("=================================================================================================\n");
+    printf("%-12s", "Position");
+    for (int j = 0; j < PERF_COUNTER_NB; j++)
+        printf(" %12s", PerfCounterNames[j]);
+    printf("\n");
+
+    for (int i = 0; strcmp(benchmarks[i], ""); i++) {
+
+        printf("Bench [# %2d]", i + 1);
+        for (int j = 0; j < PERF_COUNTER_NB; j++)
+            printPerKilonode(events[i][j], nodes[i]);
+        printf("\n");
+
+        // Any unavailable sample makes the total for that counter unavailable
+        for (int j = 0; j < PERF_COUNTER_NB; j++)
+            totals[j] = totals[j] == PERF_UNAVAILABLE || events[i][j] == PERF_UNAVAILABLE
+                      ? PERF_UNAVAILABLE : totals[j] + events[i][j];
+        totalNodes += nodes[i];
+    }
+
+    printf("=================================================================================================\n");
+    printf("%-12s", "OVERALL:");
+    for (int j = 0; j < PERF_COUNTER_NB; j++)
+        printPerKilonode(totals[j], totalNodes);
+    printf("\n");
+
+    if (   totals[PERF_CYCLES] != PERF_UNAVAILABLE
+        && totals[PERF_INSTRUCTIONS] != PERF_UNAVAILABLE)
+        printf("Instructions per cycle: %.3f\n", (double) totals[PERF_INSTRUCTIONS] / MAX(1ull, totals[PERF_CYCLES]));
 }
 
 void runEvalBook(int argc, char **argv) {
 
-    Board board;
-    char line[256];
-    Limits limits = {0};
-    uint16_t best, ponder;
+    EvalBook book = {0};
+    char line[256], moveStr[6];
     double start = getRealTime();
 
-    FILE *book    = fopen(argv[2], "r");
+    FILE *fin     = fopen(argv[2], "r");
     int depth     = argc > 3 ? atoi(argv[3]) : 12;
-    int nthreads  = argc > 4 ? atoi(argv[4]) :  1;
+    int nworkers  = argc > 4 ? atoi(argv[4]) :  1;
     int megabytes = argc > 5 ? atoi(argv[5]) :  2;
+    uint64_t nodes = argc > 6 ? strtoull(argv[6], NULL, 10) : 0ull;
+    FILE *fout    = argc > 7 ? fopen(argv[7], "w") : stdout;
 
-    Thread *threads = createThreadPool(nthreads);
+    if (fin == NULL || fout == NULL) {
+        printf("Unable to open %s\n", fin == NULL ? argv[2] : argv[7]);
+        exit(EXIT_FAILURE);
+    }
 
-    limits.multiPV = 1;
-    limits.limitedByDepth = 1;
-    limits.depthLimit = depth;
+    // Read the entire book up front, so that workers may claim positions
+    for (int size = 0; fgets(line, 256, fin) != NULL; book.count++) {
+
+        if (book.count == size)
+            book.fens = realloc(book.fens, sizeof(char*) * (size = MAX(1024, 2 * size)));
+
+        line[strcspn(line, "\r\n")] = '\0';
+        book.fens[book.count] = strdup(line);
+    }
+
+    fclose(fin);
+
+    // Searches end at a depth, or at a node count, whichever comes first.
+    // If neither is given, we fall back to the default depth of twelve
+    book.limits.multiPV        = 1;
+    book.limits.silent         = 1;
+    book.limits.limitedByNodes = nodes > 0;
+    book.limits.nodeLimit      = nodes;
+    book.limits.limitedByDepth = depth > 0 || nodes == 0;
+    book.limits.depthLimit     = depth > 0 ? depth : 12;
+
+    book.workers = MAX(1, nworkers);
+    book.results = calloc(MAX(1, book.count), sizeof(EvalBookResult));
+    pthread_mutex_init(&book.lock, NULL);
+    pthread_cond_init(&book.ready, NULL);
     initTT(megabytes);
 
-    while ((fgets(line, 256, book)) != NULL) {
-        limits.start = getRealTime();
-        boardFromFEN(&board, line, 0);
-        getBestMove(threads, &board, &limits, &best, &ponder);
-        resetThreadPool(threads); clearTT();
-        printf("FEN: %s", line);
+    pthread_t pthreads[book.workers];
+    for (int i = 0; i < book.workers; i++)
+        pthread_create(&pthreads[i], NULL, &evalBookWorker, &book);
+
+    // Results are streamed in the order of the book, as soon
+    // as each one, and every one before it, has been completed
+
+    for (int i = 0; i < book.count; i++) {
+
+        pthread_mutex_lock(&book.lock);
+        while (!book.results[i].done)
+            pthread_cond_wait(&book.ready, &book.lock);
+        pthread_mutex_unlock(&book.lock);
+
+        EvalBookResult *result = &book.results[i];
+        moveToString(result->pv.length ? result->pv.line[0] : NONE_MOVE, moveStr, 0);
+
+        fprintf(fout, "%s; ce %d; bm %s; acd %d; acn %"PRIu64"; pv",
+            book.fens[i], result->value, moveStr, result->depth, result->nodes);
+
+        for (int j = 0; j < result->pv.length; j++) {
+            moveToString(result->pv.line[j], moveStr, 0);
+            fprintf(fout, " %s", moveStr);
+        }
+
+        fprintf(fout, ";\n"), fflush(fout);
+        free(book.fens[i]);
     }
 
+    for (int i = 0; i < book.workers; i++)
+        pthread_join(pthreads[i], NULL);
+
+    if (fout != stdout) fclose(fout);
+    free(book.fens); free(book.results);
+    pthread_mutex_destroy(&book.lock);
+    pthread_cond_destroy(&book.ready);
+
     printf("Time %dms\n", (int)(getRealTime() - start));
-}
\ No newline at end of file
+    if (PROFILE) reportEvalProfile();
+}
+
+void *evalBookWorker(void *vbook) {
+
+    // Each worker is a single threaded search, with its own history
+    // and caches, and a private slice of the Transposition Table. So
+    // the results never depend on the scheduling of the other workers
+
+    EvalBook *book = (EvalBook*) vbook;
+    Thread *thread = createThreadPool(1);
+    Limits limits  = book->limits;
+    SearchInfo info;
+    Board board;
+    int index;
+
+    pthread_mutex_lock(&book->lock);
+    sliceTT(book->workers, book->started++, &thread->ttSliceMask, &thread->ttSliceBase);
+    pthread_mutex_unlock(&book->lock);
+
+    while (1) {
+
+        pthread_mutex_lock(&book->lock);
+        index = book->next++;
+        pthread_mutex_unlock(&book->lock);
+
+        if (index >= book->count) break;
+
+        // Start each position from a clean slate
+        resetThreadPool(thread);
+        clearSliceTT(thread->ttSliceMask, thread->ttSliceBase);
+        memset(&info, 0, sizeof(SearchInfo));
+
+        limits.start = getRealTime();
+        boardFromFEN(&board, book->fens[index], 0);
+        initTimeManagment(&info, &limits);
+        newSearchThreadPool(thread, &board, &limits, &info);
+        iterativeDeepening(thread);
+
+        pthread_mutex_lock(&book->lock);
+        book->results[index].depth = info.depth;
+        book->results[index].value = info.values[info.depth];
+        book->results[index].nodes = thread->nodes;
+        book->results[index].pv    = info.pv;
+        book->results[index].done  = 1;
+        pthread_cond_broadcast(&book->ready);
+        pthread_mutex_unlock(&book->lock);
+    }
+
+    deleteThreadPool(thread);
+    return NULL;
+}
+
+void runEvalProfile(int argc, char **argv) {
+
+    Board board;
+    char line[256];
+    uint64_t positions = 0ull;
+    double start = getRealTime();
+
+    FILE *book  = fopen(argv[2], "r");
+    int passes  = argc > 3 ? atoi(argv[3]) : 1;
+
+    // Static evaluations only, so a single thread holds all of the caches.
+    // Those are cleared before every pass, so that each pass over the book
+    // measures the full evaluation again, rather than the Evaluation Cache
+
+    Thread *thread = createThreadPool(1);
+
+    if (book == NULL) {
+        printf("Unable to open %s\n", argv[2]);
+        deleteThreadPool(thread);
+        return;
+    }
+
+    clearEvalProfile();
+
+    for (int i = 0; i < passes; i++, rewind(book)) {
+        resetThreadPool(thread);
+        while ((fgets(line, 256, book)) != NULL) {
+            boardFromFEN(&board, line, 0);
+            evaluateBoard(thread, &board);
+            positions++;
+        }
+    }
+
+    printf("Evaluated %d positions in %dms\n", (int)positions, (int)(getRealTime() - start));
+    reportEvalProfile();
+
+    fclose(book);
+    deleteThreadPool(thread);
+}
+
+static int moveIsPseudoLegalReference(Board *board, uint16_t move);
+
+static double timeMoveValidation(int (*validate)(Board *, uint16_t), Board *boards, int *indices, uint16_t *moves, int count) {
+
+    // Several sweeps over the same moves, returning millions of validations per second.
+    // The results are kept in a volatile, so that the validations cannot be elided
+
+    int accepted = 0;
+    double start = getRealTime();
+
+    for (int sweep = 0; sweep < MoveCheckSweeps; sweep++)
+        for (int i = 0; i < count; i++)
+            accepted += validate(&boards[indices[i]], moves[i]);
+
+    volatile int sink = accepted; (void) sink;
+
+    double elapsed = MAX(1, getRealTime() - start);
+    return MoveCheckSweeps * (count / (1000.0 * elapsed));
+}
+
+void runMoveCheck(int argc, char **argv) {
+
+    static const char *Benchmarks[] = {
+        #include "bench.csv"
+        ""
+    };
+
+    Board *boards;
+    uint16_t *pool, *moves, *split[2], legal[MAX_MOVES];
+    int *indices, *firsts, *counts, *splitIndices[2], splits[2] = {0};
+    int npositions = 0, npool = 0, mismatches = 0, generated = 0;
+
+    int samples = argc > 2 ? atoi(argv[2]) : 1000000;
+    int plies   = argc > 3 ? atoi(argv[3]) : 32;
+
+    int maxPositions = (plies + 1) * (int)(sizeof(Benchmarks) / sizeof(Benchmarks[0]));
+
+    boards  = malloc(sizeof(Board) * maxPositions);
+    firsts  = malloc(sizeof(int) * maxPositions);
+    counts  = malloc(sizeof(int) * maxPositions);
+    pool    = malloc(sizeof(uint16_t) * maxPositions * MAX_MOVES);
+    moves   = malloc(sizeof(uint16_t) * samples);
+    indices = malloc(sizeof(int) * samples);
+
+    for (int i = 0; i < 2; i++) {
+        split[i]        = malloc(sizeof(uint16_t) * samples);
+        splitIndices[i] = malloc(sizeof(int) * samples);
+    }
+
+    // Walk randomly away from each of the bench positions, saving each position
+    // along with the moves the generators produce for it. When in check, those
+    // are only the evasions, but every other pseudo legal move is still offered
+
+    for (int i = 0; strcmp(Benchmarks[i], ""); i++) {
+
+        Board board; Undo undo;
+        boardFromFEN(&board, Benchmarks[i], 0);
+
+        for (int ply = 0; ply <= plies; ply++) {
+
+            boards[npositions] = board;
+            firsts[npositions] = npool;
+            npool += genAllNoisyMoves(&board, &pool[npool]);
+            npool += genAllQuietMoves(&board, &pool[npool]);
+            counts[npositions] = npool - firsts[npositions];
+            npositions++;
+
+            int count = genAllLegalMoves(&board, legal);
+            if (!count || boardIsDrawn(&board, 0)) break;
+            applyMove(&board, legal[rand64() % count], &undo);
+        }
+    }
+
+    // Half of the moves belong to the position, like most Table, Killer, and Counter
+    // moves. The rest are moves from other positions, or occasionally arbitrary bits.
+    // Visit the positions in order, so the Board is in cache as it would be in search
+
+    for (int i = 0; i < samples; i++) {
+
+        int index = indices[i] = (int)((int64_t) i * npositions / samples);
+        int source = rand64() % 8;
+
+        moves[i] = source < 4 && counts[index] ? pool[firsts[index] + rand64() % counts[index]]
+                 : source < 7                  ? pool[rand64() % npool] : (uint16_t) rand64();
+    }
+
+    // Verify moveIsPseudoLegal() against the original implementation, and when
+    // not in check, against membership in the move generator's lists as well
+
+    for (int i = 0; i < samples; i++) {
+
+        Board *board = &boards[indices[i]];
+        int actual = moveIsPseudoLegal(board, moves[i]);
+        int reference = moveIsPseudoLegalReference(board, moves[i]);
+        int found = actual;
+
+        if (!board->kingAttackers) {
+
+            for (int j = found = 0; j < counts[indices[i]] && !found; j++)
+                found = pool[firsts[indices[i]] + j] == moves[i];
+
+            generated++;
+        }
+
+        if (actual != reference || actual != found) {
+
+            char fen[256], str[6] = "";
+            boardToFEN(board, fen);
+            moveToString(moves[i], str, 0);
+
+            if (mismatches++ < 10)
+                printf("Mismatch: %s move %s (0x%04x) returned %d, reference %d, generated %d\n",
+                        fen, str, moves[i], actual, reference, found);
+        }
+
+        // Partition the sample into accepted and rejected moves for timing
+        split[actual][splits[actual]] = moves[i];
+        splitIndices[actual][splits[actual]++] = indices[i];
+    }
+
+    printf("Checked %d moves over %d positions, %d also against the generators, %d mismatches\n",
+            samples, npositions, generated, mismatches);
+
+    printf("Accepted %d (%.2f%%), Rejected %d (%.2f%%)\n",
+            splits[1], 100.0 * splits[1] / samples, splits[0], 100.0 * splits[0] / samples);
+
+    // Time the validations alone, separately for accepted and rejected moves
+    for (int pass = 0; pass < 3; pass++) {
+        printf("Pass %d: Accepted %7.2fM/s (reference %7.2fM/s), Rejected %7.2fM/s (reference %7.2fM/s)\n", pass,
+            timeMoveValidation(moveIsPseudoLegal,          boards, splitIndices[1], split[1], splits[1]),
+            timeMoveValidation(moveIsPseudoLegalReference, boards, splitIndices[1], split[1], splits[1]),
+            timeMoveValidation(moveIsPseudoLegal,          boards, splitIndices[0], split[0], splits[0]),
+            timeMoveValidation(moveIsPseudoLegalReference, boards, splitIndices[0], split[0], splits[0]));
+    }
+
+    for (int i = 0; i < 2; i++)
+        free(split[i]), free(splitIndices[i]);
+
+    free(boards); free(firsts); free(counts);
+    free(pool); free(moves); free(indices);
+}
+
+static int moveIsPseudoLegalReference(Board *board, uint16_t move) {
+
+    // The original implementation of moveIsPseudoLegal(), before the
+    // normal piece moves were validated using the from/to tables
+
+
+    int from   = MoveFrom(move);
+    int type   = MoveType(move);
+    int ftype  = pieceType(board->squares[from]);
+    int rook, king, rookTo, kingTo;
+
+    uint64_t friendly = board->colours[ board->turn];
+    uint64_t enemy    = board->colours[!board->turn];
+    uint64_t castles  = friendly & board->castleRooks;
+    uint64_t occupied = friendly | enemy;
+    uint64_t attacks, forward, mask;
+
+    // Quick check against obvious illegal moves, such as our special move values,
+    // moving a piece that is not ours, normal move and enpass moves that have bits
+    // set which would otherwise indicate that the move is a castle or a promotion
+    if (   (move == NONE_MOVE || move == NULL_MOVE)
+        || (pieceColour(board->squares[from]) != board->turn)
+        || (MovePromoType(move) != PROMOTE_TO_KNIGHT && type == NORMAL_MOVE)
+        || (MovePromoType(move) != PROMOTE_TO_KNIGHT && type == ENPASS_MOVE))
+        return 0;
+
+    // Knight, Bishop, Rook, and Queen moves are legal so long as the
+    // move type is NORMAL and the destination is an attacked square
+
+    if (ftype == KNIGHT)
+        return type == NORMAL_MOVE
+            && testBit(knightAttacks(from) & ~friendly, MoveTo(move));
+
+    if (ftype == BISHOP)
+        return type == NORMAL_MOVE
+            && testBit(bishopAttacks(from, occupied) & ~friendly, MoveTo(move));
+
+    if (ftype == ROOK)
+        return type == NORMAL_MOVE
+            && testBit(rookAttacks(from, occupied) & ~friendly, MoveTo(move));
+
+    if (ftype == QUEEN)
+        return type == NORMAL_MOVE
+            && testBit(queenAttacks(from, occupied) & ~friendly, MoveTo(move));
+
+    if (ftype == PAWN) {
+
+        // Throw out castle moves with our pawn
+        if (type == CASTLE_MOVE)
+            return 0;
+
+        // Look at the squares which our pawn threatens
+        attacks = pawnAttacks(board->turn, from);
+
+        // Enpass moves are legal if our to square is the enpass
+        // square and we could attack a piece on the enpass square
+        if (type == ENPASS_MOVE)
+            return MoveTo(move) == board->epSquare && testBit(attacks, MoveTo(move));
+
+        // Compute simple pawn advances
+        forward = pawnAdvance(1ull << from, occupied, board->turn);
+
+        // Promotion moves are legal if we can move to one of the promotion
+        // ranks, defined by PROMOTION_RANKS, independent of moving colour
+        if (type == PROMOTION_MOVE)
+            return testBit(PROMOTION_RANKS & ((attacks & enemy) | forward), MoveTo(move));
+
+        // Add the double advance to forward
+        forward |= pawnAdvance(forward & (!board->turn ? RANK_3 : RANK_6), occupied, board->turn);
+
+        // Normal moves are legal if we can move there
+        return testBit(~PROMOTION_RANKS & ((attacks & enemy) | forward), MoveTo(move));
+    }
+
+    // The colour check should (assuming board->squares only contains
+    // pieces and EMPTY flags) ensure that ftype is an actual piece,
+    // which at this point the only piece left to check is the King
+    assert(ftype == KING);
+
+    // Normal moves are legal if the to square is a valid target
+    if (type == NORMAL_MOVE)
+        return testBit(kingAttacks(from) & ~friendly, MoveTo(move));
+
+    // Kings cannot enpass or promote
+    if (type != CASTLE_MOVE)
+        return 0;
+
+    // Verifying a castle move can be difficult, so instead we will just
+    // attempt to generate the (two) possible castle moves for the given
+    // player. If one matches, we can then verify the pseudo legality
+    // using the same code as from movegen.c
+
+    while (castles && !board->kingAttackers) {
+
+        // Figure out which pieces are moving to which squares
+        rook = poplsb(&castles), king = from;
+        rookTo = castleRookTo(king, rook);
+        kingTo = castleKingTo(king, rook);
+
+        // Make sure the move actually matches what we have
+        if (move != MoveMake(king, rook, CASTLE_MOVE)) continue;
+
+        // Castle is illegal if we would go over a piece
+        mask  = bitsBetweenMasks(king, kingTo) | (1ull << kingTo);
+        mask |= bitsBetweenMasks(rook, rookTo) | (1ull << rookTo);
+        mask &= ~((1ull << king) | (1ull << rook));
+        if (occupied & mask) return 0;
+
+        // Castle is illegal if we move through a checking threat
+        mask = bitsBetweenMasks(king, kingTo);
+        while (mask)
+            if (squareIsAttacked(board, board->turn, poplsb(&mask)))
+                return 0;
+
+        return 1; // All requirments are met
+    }
+
+    return 0;
+}
+
+static uint64_t flushSliderTables(const uint64_t *flush) {
+
+    // Read a word from each line of a buffer far larger than the L2,
+    // which evicts the attack tables along with everything else
+
+    uint64_t sum = 0ull;
+
+    for (int i = 0; i < SliderCheckFlush / (int) sizeof(uint64_t); i += 8)
+        sum += flush[i];
+
+    return sum;
+}
+
+static double timeSliderLookups(uint64_t (*rook)(int, uint64_t), uint64_t (*bishop)(int, uint64_t),
+                                uint8_t *squares, uint64_t *occupied, int count, int mode, uint64_t *flush) {
+
+    // Best of several trials, in ticks per Rook and Bishop pair. Hot lookups are independent,
+    // while dependent lookups take their occupancy from the previous attacks, as the search
+    // would when walking a line. Flushed lookups are made in batches after evicting the L2
+
+    uint64_t best = UINT64_MAX, attacks = 0ull, flushed = 0ull;
+
+    for (int trial = 0; trial < SliderCheckTrials; trial++) {
+
+        uint64_t ticks = 0ull;
+
+        for (int first = 0; first < count; first += SliderCheckBatch) {
+
+            int last = MIN(count, first + SliderCheckBatch);
+
+            if (mode == SLIDER_FLUSHED)
+                flushed += flushSliderTables(flush);
+
+            uint64_t start = readTimestamp();
+
+            for (int i = first; i < last; i++) {
+
+                if (mode == SLIDER_DEPENDENT) {
+                    attacks =   rook(squares[2*i+0], occupied[i] ^ (attacks >> 63));
+                    attacks = bishop(squares[2*i+1], occupied[i] ^ (attacks >> 63));
+                }
+
+                else attacks ^= rook(squares[2*i+0], occupied[i])
+                             ^ bishop(squares[2*i+1], occupied[i]);
+            }
+
+            ticks += readTimestamp() - start;
+        }
+
+        best = MIN(best, ticks);
+    }
+
+    volatile uint64_t sink = attacks + flushed; (void) sink;
+
+    return (double) best / count;
+}
+
+void runSliderCheck(int argc, char **argv) {
+
+    static const char *Modes[SLIDER_MODE_NB] = { "hot", "dependent", "L2 flushed" };
+    static const char *Tables[2] = { "full", "compact" };
+
+    uint64_t (*rooks[2])(int, uint64_t)   = { rookAttacks, rookAttacks };
+    uint64_t (*bishops[2])(int, uint64_t) = { bishopAttacks, bishopAttacks };
+
+    int samples = argc > 2 ? MAX(1, atoi(argv[2])) : 65536, compact = 0, mismatches = 0;
+
+    uint8_t *squares   = malloc(sizeof(uint8_t) * 2 * samples);
+    uint64_t *occupied = malloc(sizeof(uint64_t) * samples);
+    uint64_t *flush    = malloc(SliderCheckFlush);
+
+    // Written, so that every page is backed by memory of its own
+    memset(flush, 1, SliderCheckFlush);
+
+    // Random squares for each Rook and Bishop, with about a quarter of the board occupied
+    for (int i = 0; i < samples; i++) {
+        squares[2*i+0] = rand64() % SQUARE_NB;
+        squares[2*i+1] = rand64() % SQUARE_NB;
+        occupied[i]    = rand64() & rand64();
+    }
+
+#if defined(USE_COMPACT_SLIDERS)
+
+    if ((compact = initAllSliderAttacks())) {
+        rooks[0] = rookAttacksFull, rooks[1] = rookAttacksCompact;
+        bishops[0] = bishopAttacksFull, bishops[1] = bishopAttacksCompact;
+    }
+
+#endif
+
+    if (!compact)
+        printf("Compact tables are not built by this binary, which needs make compact and BMI2\n");
+
+    else {
+
+        for (int i = 0; i < samples; i++)
+            mismatches +=   rooks[0](squares[2*i+0], occupied[i]) !=   rooks[1](squares[2*i+0], occupied[i])
+                       || bishops[0](squares[2*i+1], occupied[i]) != bishops[1](squares[2*i+1], occupied[i]);
+
+        printf("Checked %d Rook and Bishop pairs, %d mismatches\n", samples, mismatches);
+    }
+
+    printf("Search uses the %s tables, indexed with %s\n",
+        Tables[compact && SliderPext], SliderPext ? "PEXT" : "Magics");
+
+    // Convert from ticks, which need not be cycles, by timing them against the clock
+    double start = getRealTime(); uint64_t ticks = readTimestamp();
+    while (getRealTime() - start < 250);
+    double ticksPerNs = (readTimestamp() - ticks) / (1e6 * (getRealTime() - start));
+
+    printf("\n%-8s %12s %12s %12s\n", "ns/pair", Modes[0], Modes[1], Modes[2]);
+
+    for (int table = 0; table <= compact; table++) {
+
+        printf("%-8s", Tables[table]);
+
+        for (int mode = 0; mode < SLIDER_MODE_NB; mode++)
+            printf(" %12.2f", timeSliderLookups(rooks[table], bishops[table],
+                squares, occupied, samples, mode, flush) / ticksPerNs);
+
+        printf("\n");
+    }
+
+    free(squares); free(occupied); free(flush);
+}
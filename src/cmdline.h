@@ -18,6 +18,41 @@
 
 #pragma once
 
+#include <pthread.h>
+#include <stdint.h>
+
+#include "perfcounters.h"
+#include "search.h"
+#include "uci.h"
+
+struct EvalBookResult {
+    int done, depth, value;
+    uint64_t nodes;
+    PVariation pv;
+};
+
+struct EvalBook {
+    char **fens;
+    int count, next, workers, started;
+    Limits limits;
+    EvalBookResult *results;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+};
+
+static const int MoveCheckSweeps = 20;
+
+enum { SLIDER_HOT, SLIDER_DEPENDENT, SLIDER_FLUSHED, SLIDER_MODE_NB };
+
+static const int SliderCheckTrials = 7;
+static const int SliderCheckBatch  = 256;
+static const int SliderCheckFlush  = 8 << 20; // Bytes read to evict the L2
+
 void handleCommandLine(int argc, char **argv);
 void runBenchmark(int argc, char **argv);
+void reportBenchPerfCounters(const char **benchmarks, uint64_t events[][PERF_COUNTER_NB], uint64_t *nodes);
 void runEvalBook(int argc, char **argv);
+void *evalBookWorker(void *vbook);
+void runEvalProfile(int argc, char **argv);
+void runMoveCheck(int argc, char **argv);
+void runSliderCheck(int argc, char **argv);
@@ -0,0 +1,163 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "attacks.h"
+#include "bitboards.h"
+#include "cpu.h"
+#include "evalprof.h"
+#include "types.h"
+
+int CPUFeatures;
+int SliderPext;
+
+static uint64_t PextTicks, MagicTicks;
+
+static int detectFeatures() {
+
+#if defined(__x86_64__) || defined(__i386__)
+
+    // Relies on cpuid, as well as xgetbv for the OS support of AVX2
+    __builtin_cpu_init();
+
+    return (__builtin_cpu_supports("popcnt") ? CPU_POPCNT : 0)
+         | (__builtin_cpu_supports("bmi2"  ) ? CPU_BMI2   : 0)
+         | (__builtin_cpu_supports("avx2"  ) ? CPU_AVX2   : 0);
+
+#else
+    return 0;
+#endif
+}
+
+static int requiredFeatures() {
+
+    // Features which the compiler was allowed to emit anywhere
+    return 0
+#if defined(__POPCNT__)
+         | CPU_POPCNT
+#endif
+#if defined(__BMI2__)
+         | CPU_BMI2
+#endif
+#if defined(__AVX2__)
+         | CPU_AVX2
+#endif
+    ;
+}
+
+#if !defined(USE_PEXT) && defined(__x86_64__)
+
+static uint64_t benchmarkSliders(int pext) {
+
+    // Time the index computation for the Rook tables, which have the
+    // most bits in each mask. PEXT is implemented in microcode on some
+    // processors, at a cost which grows with the bits in the mask. Each
+    // index feeds into the next, as a lookup in the search would, which
+    // also stops the compiler from vectorizing the Magic multiplies
+
+    uint64_t masks[SQUARE_NB], occupied[256], seed = 1070372ull, best = UINT64_MAX;
+    volatile uint64_t sink = 0ull;
+
+    for (int sq = 0; sq < SQUARE_NB; sq++)
+        masks[sq] = ( (Ranks[rankOf(sq)] & ~(FILE_A | FILE_H))
+                    | (Files[fileOf(sq)] & ~(RANK_1 | RANK_8))) & ~(1ull << sq);
+
+    for (int i = 0; i < 256; i++) {
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        occupied[i] = seed * 2685821657736338717ull;
+    }
+
+    for (int trial = 0; trial < 5; trial++) {
+
+        uint64_t index = 0ull, start = readTimestamp();
+
+        for (int i = 0; i < 256; i++)
+            for (int sq = 0; sq < SQUARE_NB; sq++)
+                index = pext ? pext64(occupied[i] ^ index, masks[sq])
+                             : (((occupied[i] ^ index) & masks[sq]) * RookMagics[sq]) >> (64 - popcount(masks[sq]));
+
+        best = MIN(best, readTimestamp() - start);
+        sink += index;
+    }
+
+    return best;
+}
+
+#endif
+
+void initCPU() {
+
+    int missing;
+
+    CPUFeatures = detectFeatures();
+
+    // Refuse to run a binary built for a newer CPU, rather than failing
+    // later on with an illegal instruction somewhere inside of a search
+
+    if ((missing = requiredFeatures() & ~CPUFeatures)) {
+        printf("This build of Ethereal requires%s%s%s, which this CPU does not support\n",
+            missing & CPU_POPCNT ? " POPCNT" : "",
+            missing & CPU_BMI2   ? " BMI2"   : "",
+            missing & CPU_AVX2   ? " AVX2"   : "");
+        exit(EXIT_FAILURE);
+    }
+
+    // Slider attacks use PEXT when forced to at compile time, or otherwise
+    // when it is available and at least as fast as the Magic multiply
+
+#if defined(USE_PEXT)
+    SliderPext = 1;
+#elif defined(__x86_64__)
+    if (CPUFeatures & CPU_BMI2) {
+        PextTicks  = benchmarkSliders(1);
+        MagicTicks = benchmarkSliders(0);
+        SliderPext = PextTicks <= MagicTicks;
+    }
+#endif
+}
+
+const char *cpuPathName() {
+
+    if (SliderPext)
+        return " (PEXT)";
+
+#if defined(__POPCNT__)
+    return " (POPCNT)";
+#else
+    return "";
+#endif
+}
+
+void reportCPU() {
+
+    printf("info string cpu%s%s%s sliders %s",
+        CPUFeatures & CPU_POPCNT ? " popcnt" : "",
+        CPUFeatures & CPU_BMI2   ? " bmi2"   : "",
+        CPUFeatures & CPU_AVX2   ? " avx2"   : "",
+        SliderPext ? "pext" : "magic");
+
+    if (PextTicks && MagicTicks)
+        printf(" (pext %"PRIu64" magic %"PRIu64" ticks)", PextTicks, MagicTicks);
+
+    printf("\n");
+}
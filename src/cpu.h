@@ -0,0 +1,71 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__BMI2__)
+    #include <immintrin.h>
+#endif
+
+#include "types.h"
+
+enum {
+    CPU_POPCNT = 1 << 0,
+    CPU_BMI2   = 1 << 1,
+    CPU_AVX2   = 1 << 2,
+};
+
+extern int CPUFeatures;  // Detected by initCPU()
+extern int SliderPext;   // Slider attacks are indexed with PEXT
+
+static inline uint64_t pext64(uint64_t bb, uint64_t mask) {
+
+#if defined(__BMI2__)
+    return _pext_u64(bb, mask);
+#elif defined(__x86_64__)
+    // Encoded directly, so that builds without -mbmi2 may still
+    // use PEXT, once initCPU() has found that the host supports it
+    uint64_t result;
+    __asm__ ("pextq %2, %1, %0" : "=r" (result) : "r" (bb), "rm" (mask));
+    return result;
+#else
+    (void) bb; (void) mask;
+    return 0ull;
+#endif
+}
+
+static inline uint64_t pdep64(uint64_t bb, uint64_t mask) {
+
+#if defined(__BMI2__)
+    return _pdep_u64(bb, mask);
+#elif defined(__x86_64__)
+    uint64_t result;
+    __asm__ ("pdepq %2, %1, %0" : "=r" (result) : "r" (bb), "rm" (mask));
+    return result;
+#else
+    (void) bb; (void) mask;
+    return 0ull;
+#endif
+}
+
+void initCPU();
+const char *cpuPathName();
+void reportCPU();
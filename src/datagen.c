@@ -0,0 +1,417 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "datagen.h"
+#include "evaluate.h"
+#include "move.h"
+#include "movegen.h"
+#include "search.h"
+#include "syzygy.h"
+#include "thread.h"
+#include "time.h"
+#include "transposition.h"
+#include "types.h"
+#include "uci.h"
+
+#include "pyrrhic/tbprobe.h"
+
+extern const char *StartPosition; // Defined by uci.c
+
+static uint64_t dataGenRandom(uint64_t *seed) {
+
+    // http://vigna.di.unimi.it/ftp/papers/xorshift.pdf
+
+    *seed ^= *seed >> 12;
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+
+    return *seed * 2685821657736338717ull;
+}
+
+static void applyGameMove(Board *board, uint16_t move) {
+
+    Undo undo[1];
+
+    // Reset the history at zeroing moves, as uciPosition() does, so that
+    // the history array only ever holds candidates for repetitions
+
+    applyMove(board, move, undo);
+    if (board->halfMoveCounter == 0)
+        board->numMoves = 0;
+}
+
+void runDataGen(int argc, char **argv) {
+
+    DataGen datagen = {0};
+
+    int games     = atoi(argv[2]);
+    int nworkers  = argc > 3 ? atoi(argv[3]) :    1;
+    uint64_t nodes = argc > 4 ? strtoull(argv[4], NULL, 10) : 5000ull;
+    char *output  = argc > 5 ? argv[5] : "FENS";
+    int megabytes = argc > 6 ? atoi(argv[6]) :   16;
+
+    if ((datagen.fout = fopen(output, "w")) == NULL) {
+        printf("Unable to open %s\n", output);
+        exit(EXIT_FAILURE);
+    }
+
+    // Tablebases are used to adjudicate games once they are within reach
+    if (argc > 7) tablebasesSetPath(argv[7]), tablebasesAwaitInit();
+
+    // Every move is a fixed node search, where the depth limit is only
+    // a safety net for positions where the node budget is never reached
+    datagen.limits.multiPV        = 1;
+    datagen.limits.silent         = 1;
+    datagen.limits.limitedByNodes = 1;
+    datagen.limits.nodeLimit      = MAX(1ull, nodes);
+    datagen.limits.limitedByDepth = 1;
+    datagen.limits.depthLimit     = MAX_PLY - 1;
+
+    datagen.games   = MAX(0, games);
+    datagen.workers = MAX(1, nworkers);
+    datagen.start   = datagen.reported = getRealTime();
+    pthread_mutex_init(&datagen.lock, NULL);
+    initTT(megabytes);
+
+    pthread_t pthreads[datagen.workers];
+    for (int i = 0; i < datagen.workers; i++)
+        pthread_create(&pthreads[i], NULL, &dataGenWorker, &datagen);
+
+    for (int i = 0; i < datagen.workers; i++)
+        pthread_join(pthreads[i], NULL);
+
+    reportDataGen(&datagen, 1);
+
+    fclose(datagen.fout);
+    pthread_mutex_destroy(&datagen.lock);
+}
+
+void *dataGenWorker(void *vdatagen) {
+
+    // Each worker plays one game at a time against itself, as a single
+    // threaded search with its own history and caches, and a private
+    // slice of the Transposition Table, exactly like evalBookWorker()
+
+    DataGen *datagen = (DataGen*) vdatagen;
+    Thread *thread = createThreadPool(1);
+    char (*fens)[128] = malloc(sizeof(*fens) * DataGenMaxPlies);
+    const char *results[] = { "[0.0]", "[0.5]", "[1.0]" };
+    int index, result, count;
+
+    pthread_mutex_lock(&datagen->lock);
+    sliceTT(datagen->workers, datagen->started++, &thread->ttSliceMask, &thread->ttSliceBase);
+    pthread_mutex_unlock(&datagen->lock);
+
+    while (1) {
+
+        pthread_mutex_lock(&datagen->lock);
+        index = datagen->next++;
+        pthread_mutex_unlock(&datagen->lock);
+
+        if (index >= datagen->games) break;
+
+        // Seeded by the game alone, so the openings played
+        // do not depend on the number of workers being used
+        uint64_t seed = DataGenSeed ^ ((index + 1) * 0x9E3779B97F4A7C15ull);
+
+        // Start each game from a clean slate
+        resetThreadPool(thread);
+        clearSliceTT(thread->ttSliceMask, thread->ttSliceBase);
+        result = playDataGenGame(datagen, thread, seed, fens, &count);
+
+        // Positions are written out a game at a time, labelled by
+        // the final result of the game from White's point of view
+
+        pthread_mutex_lock(&datagen->lock);
+
+        for (int i = 0; i < count; i++)
+            fprintf(datagen->fout, "%s %s\n", fens[i], results[result]);
+
+        datagen->finished  += 1;
+        datagen->positions += count;
+        reportDataGen(datagen, 0);
+
+        pthread_mutex_unlock(&datagen->lock);
+    }
+
+    free(fens);
+    deleteThreadPool(thread);
+    return NULL;
+}
+
+int playDataGenGame(DataGen *datagen, Thread *thread, uint64_t seed, char (*fens)[128], int *count) {
+
+    Board board;
+    SearchInfo info;
+    Limits limits = datagen->limits;
+    uint16_t moves[MAX_MOVES], move;
+    int size, value, wvalue;
+    unsigned wdl;
+    int whiteWins = 0, blackWins = 0, draws = 0;
+
+    *count = 0;
+
+    // Play random moves from the start position, retrying with the
+    // next random numbers whenever the game ends during the opening
+
+    do {
+        boardFromFEN(&board, StartPosition, 0);
+        for (int ply = 0; ply < DataGenRandomPlies; ply++) {
+            if (!(size = genAllLegalMoves(&board, moves))) break;
+            applyGameMove(&board, moves[dataGenRandom(&seed) % size]);
+        }
+    } while (!legalMoveCount(&board) || boardIsDrawn(&board, 0));
+
+    for (int ply = 0; ; ply++) {
+
+        // Games which have ended over the board
+        if (!legalMoveCount(&board))
+            return !board.kingAttackers ? 1 : board.turn == WHITE ? 0 : 2;
+
+        if (boardIsDrawn(&board, 0) || ply >= DataGenMaxPlies)
+            return 1;
+
+        // Syzygy knows the result, ignoring any Cursed Wins or Blessed Losses
+        if ((wdl = tablebasesProbeWDL(thread, &board, MAX_PLY, 1)) != TB_RESULT_FAILED) {
+            if (wdl == TB_WIN ) return board.turn == WHITE ? 2 : 0;
+            if (wdl == TB_LOSS) return board.turn == WHITE ? 0 : 2;
+            return 1;
+        }
+
+        memset(&info, 0, sizeof(SearchInfo));
+        limits.start = getRealTime();
+        initTimeManagment(&info, &limits);
+        newSearchThreadPool(thread, &board, &limits, &info);
+        iterativeDeepening(thread);
+
+        value  = info.values[info.depth];
+        move   = info.bestMoves[info.depth];
+        wvalue = board.turn == WHITE ? value : -value;
+
+        // Only quiet positions with non-mating scores are kept, since
+        // the tuner is fitting the static evaluation of each position
+
+        if (   !board.kingAttackers
+            && !moveIsTactical(&board, move)
+            &&  abs(value) < TBWIN_IN_MAX)
+            boardToFEN(&board, fens[(*count)++]);
+
+        // Adjudicate once both sides have agreed on the score for long enough
+        whiteWins = wvalue >=  DataGenWinValue ? whiteWins + 1 : 0;
+        blackWins = wvalue <= -DataGenWinValue ? blackWins + 1 : 0;
+        draws     = ply >= DataGenDrawStart && abs(value) <= DataGenDrawValue ? draws + 1 : 0;
+
+        if (whiteWins >= DataGenWinPlies) return 2;
+        if (blackWins >= DataGenWinPlies) return 0;
+        if (draws     >= DataGenDrawPlies) return 1;
+
+        applyGameMove(&board, move);
+    }
+}
+
+void reportDataGen(DataGen *datagen, int final) {
+
+    double now = getRealTime();
+    double elapsed = MAX(1.0, now - datagen->start) / 1000.0;
+
+    if (!final && now - datagen->reported < DataGenReportMS)
+        return;
+
+    datagen->reported = now;
+
+    printf("Games %8"PRIu64" of %8d  Positions %10"PRIu64"  Games/s %8.2f  Positions/s %10.1f\n",
+        datagen->finished, datagen->games, datagen->positions,
+        datagen->finished / elapsed, datagen->positions / elapsed);
+
+    fflush(stdout);
+}
+
+void runDataQuiet(int argc, char **argv) {
+
+    DataQuiet quiet = {0};
+
+    quiet.fin     = fopen(argv[2], "r");
+    quiet.fout    = fopen(argv[3], "w");
+    int nworkers  = argc > 4 ? atoi(argv[4]) :  1;
+    int megabytes = argc > 5 ? atoi(argv[5]) : 16;
+
+    if (quiet.fin == NULL || quiet.fout == NULL) {
+        printf("Unable to open %s\n", quiet.fin == NULL ? argv[2] : argv[3]);
+        exit(EXIT_FAILURE);
+    }
+
+    quiet.workers = MAX(1, nworkers);
+    quiet.start   = quiet.reported = getRealTime();
+    pthread_mutex_init(&quiet.lock, NULL);
+    pthread_cond_init(&quiet.ready, NULL);
+    initTT(megabytes);
+
+    pthread_t pthreads[quiet.workers];
+    for (int i = 0; i < quiet.workers; i++)
+        pthread_create(&pthreads[i], NULL, &dataQuietWorker, &quiet);
+
+    for (int i = 0; i < quiet.workers; i++)
+        pthread_join(pthreads[i], NULL);
+
+    reportDataQuiet(&quiet, 1);
+
+    fclose(quiet.fin); fclose(quiet.fout);
+    pthread_mutex_destroy(&quiet.lock);
+    pthread_cond_destroy(&quiet.ready);
+}
+
+void *dataQuietWorker(void *vquiet) {
+
+    // The input is streamed a chunk of lines at a time. Chunks are written
+    // out in the order that they were read, so the output is the same for
+    // any number of workers, while only a few chunks are ever held at once
+
+    DataQuiet *quiet = (DataQuiet*) vquiet;
+    Thread *thread = createThreadPool(1);
+    char (*lines)[256] = malloc(sizeof(*lines) * DataQuietChunk);
+    char (*outputs)[256] = malloc(sizeof(*outputs) * DataQuietChunk);
+    uint64_t chunk;
+    int count, kept;
+
+    pthread_mutex_lock(&quiet->lock);
+    sliceTT(quiet->workers, quiet->started++, &thread->ttSliceMask, &thread->ttSliceBase);
+    pthread_mutex_unlock(&quiet->lock);
+
+    while (1) {
+
+        pthread_mutex_lock(&quiet->lock);
+
+        for (count = 0; !quiet->eof && count < DataQuietChunk; count++)
+            if (fgets(lines[count], sizeof(*lines), quiet->fin) == NULL)
+                quiet->eof = 1, count--;
+
+        chunk = count ? quiet->claimed++ : 0;
+        pthread_mutex_unlock(&quiet->lock);
+
+        if (!count) break;
+
+        for (int i = kept = 0; i < count; i++)
+            kept += quietDataPosition(thread, lines[i], outputs[kept]);
+
+        pthread_mutex_lock(&quiet->lock);
+
+        while (quiet->written != chunk)
+            pthread_cond_wait(&quiet->ready, &quiet->lock);
+
+        for (int i = 0; i < kept; i++)
+            fputs(outputs[i], quiet->fout);
+
+        quiet->written += 1;
+        quiet->read    += count;
+        quiet->kept    += kept;
+        reportDataQuiet(quiet, 0);
+
+        pthread_cond_broadcast(&quiet->ready);
+        pthread_mutex_unlock(&quiet->lock);
+    }
+
+    free(lines); free(outputs);
+    deleteThreadPool(thread);
+    return NULL;
+}
+
+int quietDataPosition(Thread *thread, const char *line, char *output) {
+
+    Board board;
+    Undo undo[1];
+    Limits limits = {0};
+    SearchInfo info = {0};
+    PVariation pv;
+
+    char fen[128], label[16] = "", *fields[6], copy[256], *ptr = NULL;
+    int nfields = 0, value, eval;
+
+    // Split out the FEN or EPD, which may be missing its move counters,
+    // and carry over a [W/D/L] result label if the position has one
+
+    snprintf(copy, sizeof(copy), "%s", line);
+    copy[strcspn(copy, "\r\n")] = '\0';
+
+    if (strchr(line, '[') && strchr(line, ']'))
+        snprintf(label, sizeof(label), " %.*s",
+            (int) (strchr(line, ']') - strchr(line, '[') + 1), strchr(line, '['));
+
+    for (char *token = strtok_r(copy, " ", &ptr); token && nfields < 6; token = strtok_r(NULL, " ", &ptr))
+        fields[nfields++] = token;
+
+    if (nfields < 4) return 0;
+
+    snprintf(fen, sizeof(fen), "%s %s %s %s %s %s", fields[0], fields[1], fields[2], fields[3],
+        nfields > 4 && isdigit(fields[4][0]) ? fields[4] : "0",
+        nfields > 5 && isdigit(fields[5][0]) ? fields[5] : "1");
+
+    boardFromFEN(&board, fen, 0);
+
+    // Follow the qsearch PV until reaching a position where standing pat is
+    // best. Positions in check are never quiet, and are dropped, as are any
+    // which the Transposition Table cuts off before reaching such a leaf
+
+    for (int round = 0; round < DataQuietRounds; round++) {
+
+        if (board.kingAttackers) return 0;
+
+        newSearchThreadPool(thread, &board, &limits, &info);
+        value = qsearch(thread, &pv, -MATE, MATE);
+
+        if (pv.length == 0) {
+
+            if (value != (eval = evaluateBoard(thread, &thread->board)))
+                return 0;
+
+            boardToFEN(&board, fen);
+            sprintf(output, "%s%s %d %d\n", fen, label,
+                board.turn == WHITE ? eval : -eval, board.turn == WHITE ? value : -value);
+            return 1;
+        }
+
+        for (int i = 0; i < pv.length; i++)
+            applyMove(&board, pv.line[i], undo);
+    }
+
+    return 0;
+}
+
+void reportDataQuiet(DataQuiet *quiet, int final) {
+
+    double now = getRealTime();
+    double elapsed = MAX(1.0, now - quiet->start) / 1000.0;
+
+    if (!final && now - quiet->reported < DataGenReportMS)
+        return;
+
+    quiet->reported = now;
+
+    printf("Positions %10"PRIu64"  Kept %10"PRIu64"  Positions/s %10.1f\n",
+        quiet->read, quiet->kept, quiet->read / elapsed);
+
+    fflush(stdout);
+}
@@ -0,0 +1,69 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "types.h"
+#include "uci.h"
+
+static const int DataGenRandomPlies = 8;     // Random moves before the first search
+static const int DataGenMaxPlies    = 400;   // Games reaching this length are drawn
+static const int DataGenWinValue    = 1000;  // Adjudicate a win beyond this score ...
+static const int DataGenWinPlies    = 4;     // ... for this many consecutive plies
+static const int DataGenDrawValue   = 10;    // Adjudicate a draw within this score ...
+static const int DataGenDrawPlies   = 8;     // ... for this many consecutive plies
+static const int DataGenDrawStart   = 80;    // ... but never before this many plies
+static const int DataGenReportMS    = 1000;  // Minimum time between progress reports
+
+static const uint64_t DataGenSeed   = 0xDA7A6E4ull;
+
+static const int DataQuietChunk     = 4096;  // Lines claimed by a worker at a time
+static const int DataQuietRounds    = 8;     // Searches before giving up on a leaf
+
+struct DataGen {
+    FILE *fout;
+    Limits limits;
+    int games, next, workers, started;
+    uint64_t finished, positions;
+    double start, reported;
+    pthread_mutex_t lock;
+};
+
+struct DataQuiet {
+    FILE *fin, *fout;
+    int workers, started, eof;
+    uint64_t claimed, written, read, kept;
+    double start, reported;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+};
+
+void runDataGen(int argc, char **argv);
+void *dataGenWorker(void *vdatagen);
+int playDataGenGame(DataGen *datagen, Thread *thread, uint64_t seed, char (*fens)[128], int *count);
+void reportDataGen(DataGen *datagen, int final);
+
+void runDataQuiet(int argc, char **argv);
+void *dataQuietWorker(void *vquiet);
+int quietDataPosition(Thread *thread, const char *line, char *output);
+void reportDataQuiet(DataQuiet *quiet, int final);
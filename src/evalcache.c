@@ -33,6 +33,9 @@ int getCachedEvaluation(Thread *thread, Board *board, int *eval) {
 
     *eval = (int16_t)((uint16_t)(eve & 0xFFFF));
     *eval = Tempo + (board->turn == WHITE ? *eval : -*eval);
+
+    thread->evprobes++;
+    thread->evhits += key1 == key2;
     return key1 == key2;
 }
 
@@ -44,6 +47,8 @@ void storeCachedEvaluation(Thread *thread, Board *board, int eval) {
 
 PKEntry* getCachedPawnKingEval(Thread *thread, Board *board) {
     PKEntry *pke = &thread->pktable[board->pkhash & PK_CACHE_MASK];
+    thread->pkprobes++;
+    thread->pkhits += pke->pkhash == board->pkhash;
     return pke->pkhash == board->pkhash ? pke : NULL;
 }
 
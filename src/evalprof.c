@@ -0,0 +1,138 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define TIMESTAMP_UNIT "cycles"
+#else
+    #define TIMESTAMP_UNIT "ns"
+#endif
+
+#include "evalprof.h"
+#include "types.h"
+
+static uint64_t ProfileCalls[PROF_NB];
+static uint64_t ProfileTicks[PROF_NB];
+
+static const char *ProfileNames[PROF_NB] = {
+    "Eval Cache Hit", "Full Eval (PK Hit)", "Full Eval (PK Miss)",
+    "initEvalInfo", "evaluatePawns", "evaluateKingsPawns", "evaluateKnights",
+    "evaluateBishops", "evaluateRooks", "evaluateQueens", "evaluateKings",
+    "evaluatePassed", "evaluateThreats", "evaluateSpace", "evaluateClosedness",
+    "evaluateComplexity", "evaluateScaleFactor",
+};
+
+static void accumulate(uint64_t *calls, uint64_t *ticks, uint64_t elapsed) {
+    __atomic_fetch_add(calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(ticks, elapsed, __ATOMIC_RELAXED);
+}
+
+static double timestampOverhead(int record) {
+
+    // Find the average cost of an empty timed region, optionally
+    // along with the cost of recording it, so that the cost of the
+    // profiling itself may be removed from the reported figures
+
+    uint64_t calls = 0ull, ticks = 0ull, total = 0ull;
+
+    for (int i = 0; i < 100000; i++) {
+        uint64_t start = readTimestamp();
+        if (record) accumulate(&calls, &ticks, readTimestamp() - start);
+        total += readTimestamp() - start;
+    }
+
+    return total / 100000.0;
+}
+
+uint64_t readTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+
+    // Fence on both sides so that neither the compiler nor the CPU
+    // are able to drift work from a term into a neighbouring term
+
+    uint64_t ticks;
+    __asm__ __volatile__ ("" ::: "memory"); _mm_lfence();
+    ticks = __rdtsc();
+    _mm_lfence(); __asm__ __volatile__ ("" ::: "memory");
+    return ticks;
+
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return 1000000000ull * ts.tv_sec + ts.tv_nsec;
+#endif
+}
+
+void recordEvalProfile(int term, uint64_t ticks) {
+
+    // Searches may run with many threads, so we update atomically.
+    // This happens outside of the timed region of the given term
+
+    accumulate(&ProfileCalls[term], &ProfileTicks[term], ticks);
+}
+
+void clearEvalProfile() {
+    memset(ProfileCalls, 0, sizeof(ProfileCalls));
+    memset(ProfileTicks, 0, sizeof(ProfileTicks));
+}
+
+void reportEvalProfile() {
+
+    double pair, nested, ticks[PROF_NB], total = 0.0;
+
+    if (!PROFILE) {
+        printf("Evaluation profiling requires a build with -DEVALPROF (make evalprof)\n");
+        return;
+    }
+
+    // Remove the cost of taking the timestamps from every sample. Full
+    // evaluations also contain the cost of profiling each of the terms
+
+    pair   = timestampOverhead(0);
+    nested = timestampOverhead(1) * (PROF_NB - PROF_INIT);
+
+    for (int i = 0; i < PROF_NB; i++) {
+        double removed = ProfileCalls[i] * (pair + (i == PROF_EVAL_PKHIT || i == PROF_EVAL_PKMISS ? nested : 0.0));
+        ticks[i] = MAX(0.0, ProfileTicks[i] - removed);
+    }
+
+    // Every call to evaluateBoard() ends in one of the first three
+    for (int i = PROF_EVAL_CACHED; i <= PROF_EVAL_PKMISS; i++)
+        total += ticks[i];
+
+    printf("\n%-22s %14s %14s %10s\n", "Term", "Calls", TIMESTAMP_UNIT "/Call", "Share");
+    printf("=================================================================\n");
+
+    for (int i = 0; i < PROF_NB; i++) {
+
+        if (i == PROF_INIT)
+            printf("-----------------------------------------------------------------\n");
+
+        printf("%-22s %14"PRIu64" %14.1f %9.2f%%\n", ProfileNames[i], ProfileCalls[i],
+            ticks[i] / MAX(1ull, ProfileCalls[i]), 100.0 * ticks[i] / MAX(1.0, total));
+    }
+
+    printf("=================================================================\n");
+    printf("Removed %.1f " TIMESTAMP_UNIT " per term and %.1f per full evaluation as overhead\n", pair, pair + nested);
+}
@@ -0,0 +1,55 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+#ifdef EVALPROF
+    #define PROFILE (1)
+#else
+    #define PROFILE (0)
+#endif
+
+enum {
+    PROF_EVAL_CACHED, PROF_EVAL_PKHIT, PROF_EVAL_PKMISS,
+    PROF_INIT, PROF_PAWNS, PROF_KINGS_PAWNS, PROF_KNIGHTS,
+    PROF_BISHOPS, PROF_ROOKS, PROF_QUEENS, PROF_KINGS,
+    PROF_PASSED, PROF_THREATS, PROF_SPACE, PROF_CLOSEDNESS,
+    PROF_COMPLEXITY, PROF_SCALE_FACTOR, PROF_NB
+};
+
+// Time an expression which yields an int, charging the elapsed
+// ticks to the given term. Without EVALPROF this is a no-op
+
+#if defined(EVALPROF)
+    #define PROFILED(term, expr) __extension__ ({                 \
+        const uint64_t _start = readTimestamp();                  \
+        const int _value = (expr);                                \
+        recordEvalProfile((term), readTimestamp() - _start);      \
+        _value; })
+#else
+    #define PROFILED(term, expr) (expr)
+#endif
+
+uint64_t readTimestamp();
+void recordEvalProfile(int term, uint64_t ticks);
+void clearEvalProfile();
+void reportEvalProfile();
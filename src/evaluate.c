@@ -85,6 +85,7 @@
 #include "board.h"
 #include "evalcache.h"
 #include "evaluate.h"
+#include "evalprof.h"
 #include "move.h"
 #include "masks.h"
 #include "thread.h"
@@ -92,7 +93,12 @@
 #include "types.h"
 
 
-EvalTrace T, EmptyTrace;
+#ifdef TUNE
+    _Thread_local EvalTrace T; // Tuner threads each trace their own evaluations
+    EvalTrace EmptyTrace;
+#else
+    EvalTrace T, EmptyTrace;
+#endif
 int PSQT[32][SQUARE_NB];
 
 #define S(mg, eg) (MakeScore((mg), (eg)))
@@ -516,22 +522,35 @@ int evaluateBoard(Thread *thread, Board *board) {
 
     EvalInfo ei;
     int phase, factor, eval, pkeval, hashed;
+    uint64_t start;
 
     // We can recognize positions we just evaluated
     if (thread->moveStack[thread->height-1] == NULL_MOVE)
         return -thread->evalStack[thread->height-1] + 2 * Tempo;
 
+    // Profiling builds charge the entire call to one of three outcomes
+    start = PROFILE ? readTimestamp() : 0;
+
     // Check for this evaluation being cached already
-    if (!TRACE && getCachedEvaluation(thread, board, &hashed))
+    if (!TRACE && getCachedEvaluation(thread, board, &hashed)) {
+        if (PROFILE) recordEvalProfile(PROF_EVAL_CACHED, readTimestamp() - start);
         return hashed;
+    }
+
+    if (PROFILE) {
+        uint64_t init = readTimestamp();
+        initEvalInfo(thread, board, &ei);
+        recordEvalProfile(PROF_INIT, readTimestamp() - init);
+    }
+
+    else initEvalInfo(thread, board, &ei);
 
-    initEvalInfo(thread, board, &ei);
     eval = evaluatePieces(&ei, board);
 
     pkeval = ei.pkeval[WHITE] - ei.pkeval[BLACK];;
     eval += pkeval + board->psqtmat;
-    eval += evaluateClosedness(&ei, board);
-    eval += evaluateComplexity(&ei, board, eval);
+    eval += PROFILED(PROF_CLOSEDNESS, evaluateClosedness(&ei, board));
+    eval += PROFILED(PROF_COMPLEXITY, evaluateComplexity(&ei, board, eval));
 
 
     // Calculate the game phase based on remaining material (Fruit Method)
@@ -542,7 +561,7 @@ int evaluateBoard(Thread *thread, Board *board) {
     phase = (phase * 256 + 12) / 24;
 
     // Scale evaluation based on remaining material
-    factor = evaluateScaleFactor(board, eval);
+    factor = PROFILED(PROF_SCALE_FACTOR, evaluateScaleFactor(board, eval));
     if (TRACE) T.factor = factor;
 
     // Compute and store an interpolated evaluation from white's POV
@@ -554,6 +573,9 @@ int evaluateBoard(Thread *thread, Board *board) {
     if (!TRACE && ei.pkentry == NULL)
         storeCachedPawnKingEval(thread, board, ei.passedPawns, pkeval, ei.pksafety[WHITE], ei.pksafety[BLACK]);
 
+    if (PROFILE)
+        recordEvalProfile(ei.pkentry ? PROF_EVAL_PKHIT : PROF_EVAL_PKMISS, readTimestamp() - start);
+
     // Factor in the Tempo after interpolation and scaling, so that
     // if a null move is made, then we know eval = last_eval + 2 * Tempo
     return Tempo + (board->turn == WHITE ? eval : -eval);
@@ -563,25 +585,24 @@ int evaluatePieces(EvalInfo *ei, Board *board) {
 
     int eval;
 
-    eval  =   evaluatePawns(ei, board, WHITE)   - evaluatePawns(ei, board, BLACK);
+    eval  = PROFILED(PROF_PAWNS, evaluatePawns(ei, board, WHITE) - evaluatePawns(ei, board, BLACK));
 
     // This needs to be done after pawn evaluation but before king safety evaluation
-    evaluateKingsPawns(ei, board, WHITE);
-    evaluateKingsPawns(ei, board, BLACK);
-
-    eval += evaluateKnights(ei, board, WHITE) - evaluateKnights(ei, board, BLACK);
-    eval += evaluateBishops(ei, board, WHITE) - evaluateBishops(ei, board, BLACK);
-    eval +=   evaluateRooks(ei, board, WHITE)   - evaluateRooks(ei, board, BLACK);
-    eval +=  evaluateQueens(ei, board, WHITE)  - evaluateQueens(ei, board, BLACK);
-    eval +=   evaluateKings(ei, board, WHITE)   - evaluateKings(ei, board, BLACK);
-    eval +=  evaluatePassed(ei, board, WHITE)  - evaluatePassed(ei, board, BLACK);
-    eval += evaluateThreats(ei, board, WHITE) - evaluateThreats(ei, board, BLACK);
-    eval +=   evaluateSpace(ei, board, WHITE) -   evaluateSpace(ei, board, BLACK);
+    (void) PROFILED(PROF_KINGS_PAWNS, evaluateKingsPawns(ei, board, WHITE) + evaluateKingsPawns(ei, board, BLACK));
+
+    eval += PROFILED(PROF_KNIGHTS,  evaluateKnights(ei, board, WHITE) - evaluateKnights(ei, board, BLACK));
+    eval += PROFILED(PROF_BISHOPS,  evaluateBishops(ei, board, WHITE) - evaluateBishops(ei, board, BLACK));
+    eval += PROFILED(PROF_ROOKS,      evaluateRooks(ei, board, WHITE)   - evaluateRooks(ei, board, BLACK));
+    eval += PROFILED(PROF_QUEENS,    evaluateQueens(ei, board, WHITE)  - evaluateQueens(ei, board, BLACK));
+    eval += PROFILED(PROF_KINGS,      evaluateKings(ei, board, WHITE)   - evaluateKings(ei, board, BLACK));
+    eval += PROFILED(PROF_PASSED,    evaluatePassed(ei, board, WHITE)  - evaluatePassed(ei, board, BLACK));
+    eval += PROFILED(PROF_THREATS,  evaluateThreats(ei, board, WHITE) - evaluateThreats(ei, board, BLACK));
+    eval += PROFILED(PROF_SPACE,      evaluateSpace(ei, board, WHITE) -   evaluateSpace(ei, board, BLACK));
 
     return eval;
 }
 
-int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
     const int Forward = (colour == WHITE) ? 8 : -8;
@@ -692,7 +713,7 @@ int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
@@ -769,7 +790,7 @@ int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
@@ -871,7 +892,7 @@ int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
@@ -957,7 +978,7 @@ int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
@@ -1014,7 +1035,7 @@ int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateKingsPawns(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateKingsPawns(EvalInfo *ei, Board *board, int colour) {
     // Skip computations if results are cached in the Pawn King Table
     if (ei->pkentry != NULL) return 0;
 
@@ -1070,7 +1091,7 @@ int evaluateKingsPawns(EvalInfo *ei, Board *board, int colour) {
     return 0;
 }
 
-int evaluateKings(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateKings(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
@@ -1168,7 +1189,7 @@ int evaluateKings(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluatePassed(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluatePassed(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
@@ -1216,7 +1237,7 @@ int evaluatePassed(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateThreats(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateThreats(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
     // const uint64_t Rank3Rel = US == WHITE ? RANK_3 : RANK_6;
@@ -1309,7 +1330,7 @@ int evaluateThreats(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
-int evaluateSpace(EvalInfo *ei, Board *board, int colour) {
+INLINE int evaluateSpace(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
 
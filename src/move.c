@@ -574,24 +574,19 @@ int moveIsPseudoLegal(Board *board, uint16_t move) {
         || (MovePromoType(move) != PROMOTE_TO_KNIGHT && type == ENPASS_MOVE))
         return 0;
 
-    // Knight, Bishop, Rook, and Queen moves are legal so long as the
-    // move type is NORMAL and the destination is an attacked square
+    // Normal moves for all but the Pawns are legal so long as the piece could
+    // reach the destination on an empty board, nothing lies in between the two
+    // squares, and the destination is not occupied by one of our own pieces
 
-    if (ftype == KNIGHT)
-        return type == NORMAL_MOVE
-            && testBit(knightAttacks(from) & ~friendly, MoveTo(move));
+    if (ftype != PAWN && type == NORMAL_MOVE)
+        return  ((pieceMoveMasks(from, MoveTo(move)) >> ftype) & 1)
+            && !(bitsBetweenMasks(from, MoveTo(move)) & occupied)
+            && !testBit(friendly, MoveTo(move));
 
-    if (ftype == BISHOP)
-        return type == NORMAL_MOVE
-            && testBit(bishopAttacks(from, occupied) & ~friendly, MoveTo(move));
+    // Knight, Bishop, Rook, and Queen moves must otherwise be NORMAL
 
-    if (ftype == ROOK)
-        return type == NORMAL_MOVE
-            && testBit(rookAttacks(from, occupied) & ~friendly, MoveTo(move));
-
-    if (ftype == QUEEN)
-        return type == NORMAL_MOVE
-            && testBit(queenAttacks(from, occupied) & ~friendly, MoveTo(move));
+    if (ftype != PAWN && ftype != KING)
+        return 0;
 
     if (ftype == PAWN) {
 
@@ -627,10 +622,6 @@ int moveIsPseudoLegal(Board *board, uint16_t move) {
     // which at this point the only piece left to check is the King
     assert(ftype == KING);
 
-    // Normal moves are legal if the to square is a valid target
-    if (type == NORMAL_MOVE)
-        return testBit(kingAttacks(from) & ~friendly, MoveTo(move));
-
     // Kings cannot enpass or promote
     if (type != CASTLE_MOVE)
         return 0;
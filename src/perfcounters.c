@@ -0,0 +1,152 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "perfcounters.h"
+#include "types.h"
+
+const char *PerfCounterNames[PERF_COUNTER_NB] = {
+    "cycles", "instructions", "L1D-misses", "LLC-misses", "dTLB-misses", "branch-misses"
+};
+
+#if defined(__linux__)
+
+#define CACHE_EVENT(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct { uint32_t type; uint64_t config; } PerfEvents[PERF_COUNTER_NB] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES       },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS     },
+    { PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D ) },
+    { PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_LL  ) },
+    { PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES    },
+};
+
+#undef CACHE_EVENT
+
+static int readPerfCounter(PerfCounters *pc, int i, uint64_t *value) {
+
+    // Read format is { value, time_enabled, time_running }
+    uint64_t data[3];
+
+    if (read(pc->fds[i], data, sizeof(data)) != sizeof(data))
+        return 0;
+
+    *value = data[0], pc->enabled[i] = data[1], pc->running[i] = data[2];
+    return 1;
+}
+
+int initPerfCounters(PerfCounters *pc) {
+
+    // Open each counter on its own, rather than as a group, since the
+    // kernel does not allow reading an inherited group. Inheriting is
+    // needed in order to also count the helper threads of the search.
+    // Any counter the kernel or the hardware refuses is simply skipped
+
+    int opened = 0;
+    struct perf_event_attr attr;
+
+    for (int i = 0; i < PERF_COUNTER_NB; i++) {
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = PerfEvents[i].type;
+        attr.config         = PerfEvents[i].config;
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED
+                            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        pc->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        opened += pc->fds[i] != -1;
+    }
+
+    return opened;
+}
+
+void startPerfCounters(PerfCounters *pc) {
+
+    // Counts from exited children are not cleared by a reset, so
+    // we take a snapshot of each counter and report the difference
+
+    for (int i = 0; i < PERF_COUNTER_NB; i++)
+        if (pc->fds[i] != -1 && !readPerfCounter(pc, i, &pc->start[i]))
+            pc->start[i] = PERF_UNAVAILABLE;
+}
+
+void stopPerfCounters(PerfCounters *pc, uint64_t *values) {
+
+    uint64_t enabled, running, value;
+
+    for (int i = 0; i < PERF_COUNTER_NB; i++) {
+
+        values[i] = PERF_UNAVAILABLE;
+
+        if (pc->fds[i] == -1 || pc->start[i] == PERF_UNAVAILABLE)
+            continue;
+
+        enabled = pc->enabled[i], running = pc->running[i];
+
+        if (!readPerfCounter(pc, i, &value) || pc->running[i] == running)
+            continue;
+
+        // Scale up when the kernel had to multiplex the hardware counters
+        values[i] = (uint64_t)((double)(value - pc->start[i])
+                  * (pc->enabled[i] - enabled) / (pc->running[i] - running));
+    }
+}
+
+void freePerfCounters(PerfCounters *pc) {
+
+    for (int i = 0; i < PERF_COUNTER_NB; i++)
+        if (pc->fds[i] != -1) close(pc->fds[i]);
+}
+
+#else
+
+int initPerfCounters(PerfCounters *pc) {
+
+    // Hardware counters are only supported through Linux's perf_event_open()
+    for (int i = 0; i < PERF_COUNTER_NB; i++)
+        pc->fds[i] = -1;
+
+    return 0;
+}
+
+void startPerfCounters(PerfCounters *pc) { (void) pc; }
+
+void stopPerfCounters(PerfCounters *pc, uint64_t *values) {
+    (void) pc;
+    for (int i = 0; i < PERF_COUNTER_NB; i++)
+        values[i] = PERF_UNAVAILABLE;
+}
+
+void freePerfCounters(PerfCounters *pc) { (void) pc; }
+
+#endif
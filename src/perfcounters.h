@@ -0,0 +1,46 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+enum {
+    PERF_CYCLES, PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES, PERF_LLC_MISSES,
+    PERF_DTLB_MISSES, PERF_BRANCH_MISSES,
+    PERF_COUNTER_NB
+};
+
+static const uint64_t PERF_UNAVAILABLE = UINT64_MAX;
+
+struct PerfCounters {
+    int fds[PERF_COUNTER_NB];
+    uint64_t enabled[PERF_COUNTER_NB];
+    uint64_t running[PERF_COUNTER_NB];
+    uint64_t start[PERF_COUNTER_NB];
+};
+
+extern const char *PerfCounterNames[PERF_COUNTER_NB];
+
+int initPerfCounters(PerfCounters *pc);
+void startPerfCounters(PerfCounters *pc);
+void stopPerfCounters(PerfCounters *pc, uint64_t *values);
+void freePerfCounters(PerfCounters *pc);
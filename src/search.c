@@ -36,6 +36,7 @@
 #include "movegen.h"
 #include "movepicker.h"
 #include "search.h"
+#include "searchtrace.h"
 #include "syzygy.h"
 #include "thread.h"
 #include "time.h"
@@ -49,6 +50,42 @@ volatile int ABORT_SIGNAL; // Global ABORT flag for threads
 volatile int IS_PONDERING; // Global PONDER flag for threads
 volatile int ANALYSISMODE; // Whether to make some changes for Analysis
 
+// Every exit from search() and qsearch() passes through the Search Trace
+#define TRACED(step, value) \
+    traceNodeExit(thread, (step), depth, oldAlpha, beta, entryNodes, (value))
+#define TRACED_QS(step, value) \
+    traceNodeExit(thread, (step) | TRACE_QSEARCH, 0, oldAlpha, beta, entryNodes, (value))
+
+static inline int traceNodeExit(Thread *thread, int step, int depth, int alpha, int beta, uint64_t entry, int value) {
+
+    // Nodes are recorded as they exit, so that the size of their subtree is
+    // known. Disabled traces cost no more than this single, predictable branch
+
+    if (thread->trace.events != NULL) {
+
+        TraceEvent *event = &thread->trace.events[thread->trace.count++ & thread->trace.mask];
+
+        event->alpha  = alpha;
+        event->beta   = beta;
+        event->value  = value;
+        event->move   = thread->moveStack[thread->height-1];
+        event->height = thread->height;
+        event->depth  = MIN(depth, MAX_PLY);
+        event->step   = step;
+        event->nodes  = MIN(thread->nodes - entry, UINT32_MAX);
+    }
+
+    return value;
+}
+
+static inline uint64_t ttKey(Thread *thread, uint64_t hash) {
+
+    // Threads may be confined to a slice of the Transposition Table,
+    // in which case the upper bits of the bucket index are replaced
+
+    return (hash & ~thread->ttSliceMask) | thread->ttSliceBase;
+}
+
 void initSearch() {
 
     // Init Late Move Reductions Table
@@ -120,6 +157,7 @@ void* iterativeDeepening(void *vthread) {
         info->values[info->depth]      = thread->values[0];
         info->bestMoves[info->depth]   = thread->bestMoves[0];
         info->ponderMoves[info->depth] = thread->ponderMoves[0];
+        memcpy(&info->pv, &thread->pv, sizeof(PVariation));
 
         // Update time allocation based on score and pv changes
         updateTimeManagment(info, limits);
@@ -157,8 +195,8 @@ void aspirationWindow(Thread *thread) {
 
         // Perform a search and consider reporting results
         value = search(thread, pv, alpha, beta, MAX(1, depth));
-        if (   (mainThread && value > alpha && value < beta)
-            || (mainThread && elapsedTime(thread->info) >= WindowTimerMS))
+        if (   (mainThread && !thread->limits->silent && value > alpha && value < beta)
+            || (mainThread && !thread->limits->silent && elapsedTime(thread->info) >= WindowTimerMS))
             uciReport(thread->threads, alpha, beta, value);
 
         // Search returned a result within our window
@@ -205,13 +243,15 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
     MovePicker movePicker;
     PVariation lpv;
 
+    const uint64_t entryNodes = thread->nodes;
+
     // Step 1. Quiescence Search. Perform a search using mostly tactical
     // moves to reach a more stable position for use as a static evaluation
     if (depth <= 0 && !board->kingAttackers)
         return qsearch(thread, pv, alpha, beta);
 
     // Prefetch TT as early as reasonable
-    prefetchTTEntry(board->hash);
+    prefetchTTEntry(ttKey(thread, board->hash));
 
     // Ensure a fresh PV
     pv->length = 0;
@@ -234,23 +274,32 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
 
         // Draw Detection. Check for the fifty move rule, repetition, or insufficient
         // material. Add variance to the draw score, to avoid blindness to 3-fold lines
-        if (boardIsDrawn(board, thread->height)) return 1 - (thread->nodes & 2);
+        if (boardIsDrawn(board, thread->height)) return TRACED(TRACE_DRAW, 1 - (thread->nodes & 2));
+
+        // Upcoming Repetition. If we have a reversible move which repeats an earlier
+        // position, then we can claim at least a draw. Raise alpha, and cut if that fails high
+        if (alpha < 0 && boardHasUpcomingCycle(board, thread->height)) {
+            oldAlpha = alpha = 1 - (thread->nodes & 2);
+            if (alpha >= beta) return TRACED(TRACE_CYCLE, alpha);
+        }
 
         // Check to see if we have exceeded the maxiumum search draft
         if (thread->height >= MAX_PLY)
-            return evaluateBoard(thread, board);
+            return TRACED(TRACE_MAX_PLY, evaluateBoard(thread, board));
 
         // Mate Distance Pruning. Check to see if this line is so
         // good, or so bad, that being mated in the ply, or  mating in
         // the next one, would still not create a more extreme line
         rAlpha = alpha > -MATE + thread->height     ? alpha : -MATE + thread->height;
         rBeta  =  beta <  MATE - thread->height - 1 ?  beta :  MATE - thread->height - 1;
-        if (rAlpha >= rBeta) return rAlpha;
+        if (rAlpha >= rBeta) return TRACED(TRACE_MATE_DISTANCE, rAlpha);
     }
 
     // Step 4. Probe the Transposition Table, adjust the value, and consider cutoffs
-    if ((ttHit = getTTEntry(board->hash, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))) {
+    thread->ttprobes++;
+    if ((ttHit = getTTEntry(ttKey(thread, board->hash), &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))) {
 
+        thread->tthits++; // Telemetry for the UCI stats command
         ttValue = valueFromTT(ttValue, thread->height); // Adjust any MATE scores
 
         // Only cut with a greater depth search, and do not return
@@ -261,14 +310,14 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
             if (    ttBound == BOUND_EXACT
                 || (ttBound == BOUND_LOWER && ttValue >= beta)
                 || (ttBound == BOUND_UPPER && ttValue <= alpha))
-                return ttValue;
+                return TRACED(TRACE_TT_CUTOFF, ttValue);
         }
     }
 
     // Step 5. Probe the Syzygy Tablebases. tablebasesProbeWDL() handles all of
     // the conditions about the board, the existance of tables, the probe depth,
     // as well as to not probe at the Root. The return is defined by the Pyrrhic API
-    if ((tbresult = tablebasesProbeWDL(board, depth, thread->height)) != TB_RESULT_FAILED) {
+    if ((tbresult = tablebasesProbeWDL(thread, board, depth, thread->height)) != TB_RESULT_FAILED) {
 
         thread->tbhits++; // Increment tbhits counter for this thread
 
@@ -288,8 +337,8 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
             || (ttBound == BOUND_LOWER && value >= beta)
             || (ttBound == BOUND_UPPER && value <= alpha)) {
 
-            storeTTEntry(board->hash, NONE_MOVE, valueToTT(value, thread->height), VALUE_NONE, depth, ttBound);
-            return value;
+            storeTTEntry(ttKey(thread, board->hash), NONE_MOVE, valueToTT(value, thread->height), VALUE_NONE, depth, ttBound);
+            return TRACED(TRACE_TABLEBASE, value);
         }
     }
 
@@ -327,7 +376,7 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
         && !inCheck
         &&  depth <= BetaPruningDepth
         &&  eval - BetaMargin * depth > beta)
-        return eval;
+        return TRACED(TRACE_BETA_PRUNING, eval);
 
     // Step 8 (~3 elo). Alpha Pruning for main search loop. The idea is
     // that for low depths if eval is so bad that even a large static
@@ -336,7 +385,7 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
         && !inCheck
         &&  depth <= AlphaPruningDepth
         &&  eval + AlphaMargin <= alpha)
-        return eval;
+        return TRACED(TRACE_ALPHA_PRUNING, eval);
 
     // Step 9 (~93 elo). Null Move Pruning. If our position is so good that giving
     // our opponent back-to-back moves is still not enough for them to
@@ -358,7 +407,7 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
         value = -search(thread, &lpv, -beta, -beta+1, depth-R);
         revert(thread, board, NULL_MOVE);
 
-        if (value >= beta) return beta;
+        if (value >= beta) return TRACED(TRACE_NULL_MOVE, beta);
     }
 
     // Step 10 (~9 elo). Probcut Pruning. If we have a good capture that causes a cutoff
@@ -389,7 +438,7 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
             revert(thread, board, move);
 
             // Probcut failed high verifying the cutoff
-            if (value >= rBeta) return value;
+            if (value >= rBeta) return TRACED(TRACE_PROBCUT, value);
         }
     }
 
@@ -474,7 +523,7 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
         // The UCI spec allows us to output information about the current move
         // that we are going to search. We only do this from the main thread,
         // and we wait a few seconds in order to avoid floiding the output
-        if (RootNode && !thread->index && elapsedTime(thread->info) > CurrmoveTimerMS)
+        if (RootNode && !thread->index && !thread->limits->silent && elapsedTime(thread->info) > CurrmoveTimerMS)
             uciReportCurrentMove(board, move, played + thread->multiPV, thread->depth);
 
         // Identify moves which are candidate singular moves
@@ -500,7 +549,7 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
 
         if (movePicker.stage == STAGE_DONE) {
             revert(thread, board, move);
-            return MAX(ttValue - depth, -MATE);
+            return TRACED(TRACE_MULTICUT, MAX(ttValue - depth, -MATE));
         }
 
         // Step 17A (~249 elo). Quiet Late Move Reductions. Reduce the search depth
@@ -588,14 +637,14 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
     }
 
     // Prefetch TT for store
-    prefetchTTEntry(board->hash);
+    prefetchTTEntry(ttKey(thread, board->hash));
 
     // Step 20. Stalemate and Checkmate detection. If no moves were found to
     // be legal (search makes sure to play at least one legal move, if any),
     // then we are either mated or stalemated, which we can tell by the inCheck
     // flag. For mates, return a score based on the distance from root, so we
     // can differentiate between close mates and far away mates from the root
-    if (played == 0) return inCheck ? -MATE + thread->height : 0;
+    if (played == 0) return TRACED(TRACE_NO_MOVES, inCheck ? -MATE + thread->height : 0);
 
     // Step 21 (~760 elo). Update History counters on a fail high for a quiet move.
     // We also update Capture History Heuristics, which augment or replace MVV-LVA.
@@ -611,24 +660,26 @@ int search(Thread *thread, PVariation *pv, int alpha, int beta, int depth) {
     if (!RootNode || !thread->multiPV) {
         ttBound = best >= beta    ? BOUND_LOWER
                 : best > oldAlpha ? BOUND_EXACT : BOUND_UPPER;
-        storeTTEntry(board->hash, bestMove, valueToTT(best, thread->height), eval, depth, ttBound);
+        storeTTEntry(ttKey(thread, board->hash), bestMove, valueToTT(best, thread->height), eval, depth, ttBound);
     }
 
-    return best;
+    return TRACED(TRACE_SEARCHED, best);
 }
 
 int qsearch(Thread *thread, PVariation *pv, int alpha, int beta) {
 
     Board *const board = &thread->board;
 
-    int eval, value, best;
+    int eval, value, best, oldAlpha = alpha;
     int ttHit, ttValue = 0, ttEval = VALUE_NONE, ttDepth = 0, ttBound = 0;
     uint16_t move, ttMove = NONE_MOVE;
     MovePicker movePicker;
     PVariation lpv;
 
+    const uint64_t entryNodes = thread->nodes;
+
     // Prefetch TT as early as reasonable
-    prefetchTTEntry(board->hash);
+    prefetchTTEntry(ttKey(thread, board->hash));
 
     // Ensure a fresh PV
     pv->length = 0;
@@ -644,23 +695,25 @@ int qsearch(Thread *thread, PVariation *pv, int alpha, int beta) {
 
     // Step 2. Draw Detection. Check for the fifty move rule, repetition, or insufficient
     // material. Add variance to the draw score, to avoid blindness to 3-fold lines
-    if (boardIsDrawn(board, thread->height)) return 1 - (thread->nodes & 2);
+    if (boardIsDrawn(board, thread->height)) return TRACED_QS(TRACE_DRAW, 1 - (thread->nodes & 2));
 
     // Step 3. Max Draft Cutoff. If we are at the maximum search draft,
     // then end the search here with a static eval of the current board
     if (thread->height >= MAX_PLY)
-        return evaluateBoard(thread, board);
+        return TRACED_QS(TRACE_MAX_PLY, evaluateBoard(thread, board));
 
     // Step 4. Probe the Transposition Table, adjust the value, and consider cutoffs
-    if ((ttHit = getTTEntry(board->hash, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))) {
+    thread->ttprobes++;
+    if ((ttHit = getTTEntry(ttKey(thread, board->hash), &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))) {
 
+        thread->tthits++; // Telemetry for the UCI stats command
         ttValue = valueFromTT(ttValue, thread->height); // Adjust any MATE scores
 
         // Table is exact or produces a cutoff
         if (    ttBound == BOUND_EXACT
             || (ttBound == BOUND_LOWER && ttValue >= beta)
             || (ttBound == BOUND_UPPER && ttValue <= alpha))
-            return ttValue;
+            return TRACED_QS(TRACE_TT_CUTOFF, ttValue);
     }
 
     // Save a history of the static evaluations
@@ -672,13 +725,13 @@ int qsearch(Thread *thread, PVariation *pv, int alpha, int beta) {
     // eval exceeds alpha, we can call our static eval the new alpha
     best = eval;
     alpha = MAX(alpha, eval);
-    if (alpha >= beta) return eval;
+    if (alpha >= beta) return TRACED_QS(TRACE_STAND_PAT, eval);
 
     // Step 6. Delta Pruning. Even the best possible capture and or promotion
     // combo, with a minor boost for pawn captures, would still fail to cover
     // the distance between alpha and the evaluation. Playing a move is futile.
     if (MAX(QSDeltaMargin, moveBestCaseValue(board)) < alpha - eval)
-        return eval;
+        return TRACED_QS(TRACE_DELTA_PRUNING, eval);
 
     // Step 7. Move Generation and Looping. Generate all tactical moves
     // and return those which are winning via SEE, and also strong enough
@@ -708,10 +761,10 @@ int qsearch(Thread *thread, PVariation *pv, int alpha, int beta) {
 
         // Search has failed high
         if (alpha >= beta)
-            return best;
+            return TRACED_QS(TRACE_SEARCHED, best);
     }
 
-    return best;
+    return TRACED_QS(TRACE_SEARCHED, best);
 }
 
 int staticExchangeEvaluation(Board *board, uint16_t move, int threshold) {
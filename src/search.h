@@ -22,16 +22,17 @@
 
 #include "types.h"
 
+struct PVariation {
+    uint16_t line[MAX_PLY];
+    int length;
+};
+
 struct SearchInfo {
     int depth, values[MAX_PLY];
     uint16_t bestMoves[MAX_PLY], ponderMoves[MAX_PLY];
     double startTime, idealUsage, maxAlloc, maxUsage;
     int pvFactor;
-};
-
-struct PVariation {
-    uint16_t line[MAX_PLY];
-    int length;
+    PVariation pv;
 };
 
 void initSearch();
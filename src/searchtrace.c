@@ -0,0 +1,227 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "move.h"
+#include "searchtrace.h"
+#include "thread.h"
+#include "types.h"
+
+static const char TraceMagic[4] = { 'E', 'T', 'R', 'C' };
+static const uint32_t TraceVersion = 2;
+
+static const char *TraceStepNames[TRACE_STEP_NB] = {
+    "Draw", "Upcoming Cycle", "Max Ply", "Mate Distance",
+    "TT Cutoff", "Tablebase", "Beta Pruning", "Alpha Pruning",
+    "Null Move", "Probcut", "MultiCut", "No Moves",
+    "Stand Pat", "Delta Pruning", "Searched",
+};
+
+void resizeSearchTrace(Thread *threads, int megabytes) {
+
+    // Each Thread owns a ring buffer of the most recent node exits. The
+    // capacity is the largest power of two which fits within the size
+
+    uint64_t capacity = 1ull;
+    uint64_t entries  = ((uint64_t) megabytes << 20) / sizeof(TraceEvent);
+
+    while (capacity * 2 <= entries)
+        capacity *= 2;
+
+    for (int i = 0; i < threads->nthreads; i++) {
+
+        free(threads[i].trace.events);
+        memset(&threads[i].trace, 0, sizeof(SearchTrace));
+
+        if (megabytes <= 0) continue;
+
+        threads[i].trace.events = malloc(capacity * sizeof(TraceEvent));
+        threads[i].trace.mask   = capacity - 1;
+    }
+}
+
+int dumpSearchTrace(Thread *threads, const char *fname) {
+
+    // Dump each ring buffer, oldest event first. The format is a small
+    // header, then for each thread the total number of events seen, the
+    // number which are being written, and then the raw events themselves
+
+    FILE *fout = fopen(fname, "wb");
+    uint32_t nthreads = threads->nthreads, size = sizeof(TraceEvent);
+
+    if (fout == NULL) return 0;
+
+    fwrite(TraceMagic, sizeof(TraceMagic), 1, fout);
+    fwrite(&TraceVersion, sizeof(uint32_t), 1, fout);
+    fwrite(&nthreads, sizeof(uint32_t), 1, fout);
+    fwrite(&size, sizeof(uint32_t), 1, fout);
+
+    for (int i = 0; i < threads->nthreads; i++) {
+
+        SearchTrace *trace = &threads[i].trace;
+        uint64_t capacity  = trace->events ? trace->mask + 1 : 0ull;
+        uint64_t stored    = MIN(trace->count, capacity);
+        uint64_t first     = trace->count - stored;
+
+        fwrite(&trace->count, sizeof(uint64_t), 1, fout);
+        fwrite(&stored, sizeof(uint64_t), 1, fout);
+
+        for (uint64_t j = first; j < trace->count; j++)
+            fwrite(&trace->events[j & trace->mask], sizeof(TraceEvent), 1, fout);
+    }
+
+    fclose(fout);
+    return 1;
+}
+
+static void printTraceLine(TraceEvent *events, uint64_t length, uint64_t index) {
+
+    // Events are recorded on exit, so the parent of a node is the first
+    // event which follows it at one less ply. Walk up to build the line
+
+    uint16_t line[MAX_PLY + 1];
+    int height = events[index].height, plies = 0;
+    char moveStr[6];
+
+    line[plies++] = events[index].move;
+
+    for (uint64_t i = index + 1; i < length && height > 1; i++) {
+        if (events[i].height == height - 1) {
+            line[plies++] = events[i].move;
+            height = events[i].height;
+        }
+    }
+
+    // The root of the line may have been lost to an aborted search
+    if (height > 1) printf(" ...");
+
+    while (plies--) {
+        if (line[plies] == NULL_MOVE) printf(" null");
+        else moveToString(line[plies], moveStr, 0), printf(" %s", moveStr);
+    }
+
+    printf("\n");
+}
+
+void summarizeSearchTrace(const char *fname) {
+
+    char magic[4];
+    uint32_t version, nthreads, size;
+    uint64_t steps[TRACE_STEP_NB][2] = {0}, depths[MAX_PLY + 1][4] = {0};
+    uint64_t total = 0ull, malformed = 0ull;
+
+    FILE *fin = fopen(fname, "rb");
+
+    if (   fin == NULL
+        || fread(magic, sizeof(magic), 1, fin) != 1
+        || memcmp(magic, TraceMagic, sizeof(magic))
+        || fread(&version, sizeof(uint32_t), 1, fin) != 1
+        || fread(&nthreads, sizeof(uint32_t), 1, fin) != 1
+        || fread(&size, sizeof(uint32_t), 1, fin) != 1
+        || version != TraceVersion || size != sizeof(TraceEvent)) {
+        printf("Unable to read a Search Trace from %s\n", fname);
+        if (fin != NULL) fclose(fin);
+        return;
+    }
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+
+        uint64_t recorded, stored, hottest[10] = {0};
+        TraceEvent *events;
+
+        if (   fread(&recorded, sizeof(uint64_t), 1, fin) != 1
+            || fread(&stored, sizeof(uint64_t), 1, fin) != 1)
+            break;
+
+        events = malloc(MAX(1ull, stored) * sizeof(TraceEvent));
+        if (fread(events, sizeof(TraceEvent), stored, fin) != stored) {
+            free(events);
+            break;
+        }
+
+        printf("\nThread %2u: %"PRIu64" of %"PRIu64" node exits retained\n", i, stored, recorded);
+
+        for (uint64_t j = 0; j < stored; j++) {
+
+            TraceEvent *e = &events[j];
+            int qs = !!(e->step & TRACE_QSEARCH), step = e->step & ~TRACE_QSEARCH;
+
+            // Never trust the file to index our tables, as it may be damaged
+            if (step >= TRACE_STEP_NB || e->depth > MAX_PLY || e->height > MAX_PLY) {
+                malformed++;
+                continue;
+            }
+
+            steps[step][qs]++;
+            total++;
+
+            // Bucket main search nodes by depth, and by the result
+            // relative to the window. Pruned nodes are noted apart
+            if (!qs) {
+                depths[e->depth][0]++;
+                depths[e->depth][1] += step != TRACE_SEARCHED && step != TRACE_NO_MOVES;
+                depths[e->depth][2] += e->value <= e->alpha;
+                depths[e->depth][3] += e->value >= e->beta;
+            }
+
+            // Insertion into the ten largest subtrees below the root
+            if (e->height == 0 || (hottest[9] && e->nodes <= events[hottest[9] - 1].nodes))
+                continue;
+
+            int k = 9;
+            for (; k > 0 && (!hottest[k-1] || e->nodes > events[hottest[k-1] - 1].nodes); k--)
+                hottest[k] = hottest[k-1];
+            hottest[k] = j + 1;
+        }
+
+        printf("   Nodes Height Depth   Alpha    Beta   Value Step           Line\n");
+
+        for (int k = 0; k < 10 && hottest[k]; k++) {
+            TraceEvent *e = &events[hottest[k] - 1];
+            printf("%8"PRIu32" %6d %5d %7d %7d %7d %-14s",
+                e->nodes, e->height, e->depth, e->alpha, e->beta, e->value,
+                TraceStepNames[e->step & ~TRACE_QSEARCH]);
+            printTraceLine(events, stored, hottest[k] - 1);
+        }
+
+        free(events);
+    }
+
+    fclose(fin);
+
+    if (malformed)
+        printf("\nIgnored %"PRIu64" malformed node exits\n", malformed);
+
+    printf("\n%-16s %12s %12s %8s\n", "Exit Step", "Search", "QSearch", "Share");
+    for (int i = 0; i < TRACE_STEP_NB; i++)
+        printf("%-16s %12"PRIu64" %12"PRIu64" %7.2f%%\n", TraceStepNames[i], steps[i][0], steps[i][1],
+            100.0 * (steps[i][0] + steps[i][1]) / MAX(1ull, total));
+
+    printf("\n%5s %12s %8s %8s %8s\n", "Depth", "Nodes", "Pruned", "FailLow", "FailHigh");
+    for (int i = 0; i <= MAX_PLY; i++) {
+        if (!depths[i][0]) continue;
+        printf("%5d %12"PRIu64" %7.2f%% %7.2f%% %7.2f%%\n", i, depths[i][0],
+            100.0 * depths[i][1] / depths[i][0], 100.0 * depths[i][2] / depths[i][0],
+            100.0 * depths[i][3] / depths[i][0]);
+    }
+}
@@ -0,0 +1,48 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+enum {
+    TRACE_DRAW, TRACE_CYCLE, TRACE_MAX_PLY, TRACE_MATE_DISTANCE,
+    TRACE_TT_CUTOFF, TRACE_TABLEBASE, TRACE_BETA_PRUNING, TRACE_ALPHA_PRUNING,
+    TRACE_NULL_MOVE, TRACE_PROBCUT, TRACE_MULTICUT, TRACE_NO_MOVES,
+    TRACE_STAND_PAT, TRACE_DELTA_PRUNING, TRACE_SEARCHED, TRACE_STEP_NB,
+};
+
+enum { TRACE_QSEARCH = 0x80 };
+
+struct TraceEvent {
+    int16_t alpha, beta, value;
+    uint16_t move;
+    uint8_t height, depth, step, padding;
+    uint32_t nodes;
+};
+
+struct SearchTrace {
+    TraceEvent *events;
+    uint64_t mask, count;
+};
+
+void resizeSearchTrace(Thread *threads, int megabytes);
+int dumpSearchTrace(Thread *threads, const char *fname);
+void summarizeSearchTrace(const char *fname);
@@ -17,22 +17,56 @@
 */
 
 #include <assert.h>
+#include <ctype.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <windows.h>
+#else
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #include "bitboards.h"
 #include "board.h"
 #include "pyrrhic/tbprobe.h"
 #include "move.h"
 #include "movegen.h"
+#include "syzygy.h"
+#include "thread.h"
+#include "time.h"
 #include "types.h"
 #include "uci.h"
 
 unsigned TB_PROBE_DEPTH;          // Set by UCI options
-extern int TB_LARGEST;       // Set by Pyrrhic in tb_init()
+extern int TB_LARGEST;            // Set by Pyrrhic in tb_init()
 extern volatile int ANALYSISMODE; // Defined by Search.c
 
+static int TB_PUBLISHED;          // TB_LARGEST, once tb_init() has finished
+static char SyzygyPath[4096];     // Set by UCI options
+static char SyzygyPreload[1024];  // Set by UCI options
+static TBPreload Preload;
+
+static pthread_t SyzygyInit;
+static int SyzygyInitRunning;
+static pthread_mutex_t SyzygyLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int tablebasesLargest() {
+
+    // Pyrrhic's tables are only safe to probe once tb_init() has completed,
+    // which is published with release semantics by initTablebases(). Until
+    // then, or without any Tablebases, this is zero and no probes are made
+
+    return __atomic_load_n(&TB_PUBLISHED, __ATOMIC_ACQUIRE);
+}
+
 static uint16_t convertPyrrhicMove(Board *board, unsigned result) {
 
     // Extract Pyrhic's move representation
@@ -64,11 +98,12 @@ int tablebasesProbeDTZ(Board *board, Limits *limits, uint16_t *best, uint16_t *p
     unsigned results[MAX_MOVES];
     uint64_t white = board->colours[WHITE];
     uint64_t black = board->colours[BLACK];
+    int largest = tablebasesLargest();
 
     // We cannot probe when there are castling rights, or when
     // we have more pieces than our largest Tablebase has pieces
     if (   board->castleRooks
-        || popcount(white | black) > TB_LARGEST)
+        || popcount(white | black) > largest)
         return 0;
 
     // Tap into Pyrrhic's API. Pyrrhic takes the board representation and the
@@ -104,10 +139,13 @@ int tablebasesProbeDTZ(Board *board, Limits *limits, uint16_t *best, uint16_t *p
     return !ANALYSISMODE;
 }
 
-unsigned tablebasesProbeWDL(Board *board, int depth, int height) {
+unsigned tablebasesProbeWDL(Thread *thread, Board *board, int depth, int height) {
 
     uint64_t white = board->colours[WHITE];
     uint64_t black = board->colours[BLACK];
+    TBEntry *tbe = &thread->tbtable[board->hash & TB_CACHE_MASK];
+    int largest = tablebasesLargest();
+    unsigned result;
 
     // Never take a Syzygy Probe in a Root node, in a node with Castling rights,
     // in a node which was not just zero'ed by a Pawn Move or Capture, or in a
@@ -116,7 +154,7 @@ unsigned tablebasesProbeWDL(Board *board, int depth, int height) {
     if (   height == 0
         || board->castleRooks
         || board->halfMoveCounter
-        || popcount(white | black) > TB_LARGEST)
+        || popcount(white | black) > largest)
         return TB_RESULT_FAILED;
 
 
@@ -126,15 +164,25 @@ unsigned tablebasesProbeWDL(Board *board, int depth, int height) {
     // probe the 6man Tablebase if possible, irregardless of TB_PROBE_DEPTH
 
     if (   depth < (int) TB_PROBE_DEPTH
-        && popcount(white | black) == TB_LARGEST)
+        && popcount(white | black) == largest)
         return TB_RESULT_FAILED;
 
 
+    // Each probe decompresses a block of the Tablebase, so the results are
+    // cached per Thread. The upper bits of the hash serve as the key, and
+    // the lower three bits hold the WDL, which is always between 0 and 4
+
+    thread->wdlprobes++;
+    if ((*tbe & ~0x7ull) == (board->hash & ~0x7ull)) {
+        thread->wdlhits++;
+        return (unsigned) (*tbe & 0x7ull);
+    }
+
     // Tap into Pyrrhic's API. Pyrrhic takes the board representation, followed
     // by the enpass square (0 if none set), and the turn. Pyrrhic defines WHITE
     // as 1, and BLACK as 0, which is the opposite of how Ethereal defines them
 
-    return tb_probe_wdl(
+    result = tb_probe_wdl(
         board->colours[WHITE], board->colours[BLACK],
         board->pieces[KING  ], board->pieces[QUEEN ],
         board->pieces[ROOK  ], board->pieces[BISHOP],
@@ -142,4 +190,299 @@ unsigned tablebasesProbeWDL(Board *board, int depth, int height) {
         board->epSquare == -1 ? 0 : board->epSquare,
         board->turn == WHITE ? 1 : 0
     );
+
+    if (result != TB_RESULT_FAILED)
+        *tbe = (board->hash & ~0x7ull) | result;
+
+    return result;
+}
+
+static void *initTablebases(void *unused) {
+
+    (void) unused;
+
+    double start = getRealTime();
+
+    // Scanning the directories and opening each file may take a long
+    // time on large or remote Tablebases, so this is done in the
+    // background while the engine searches without any Tablebases
+
+    tb_init(SyzygyPath);
+
+    pthread_mutex_lock(&SyzygyLock);
+    __atomic_store_n(&TB_PUBLISHED, TB_LARGEST, __ATOMIC_RELEASE);
+    printf("info string Syzygy ready with %d-men in %d ms\n", TB_LARGEST, (int) (getRealTime() - start));
+    fflush(stdout);
+    tablebasesStartPreload();
+    pthread_mutex_unlock(&SyzygyLock);
+
+    return NULL;
+}
+
+void tablebasesSetPath(const char *path) {
+
+    // Pyrrhic can only be initialized once at a time. Probes are disabled
+    // before tb_init() is called again, since it frees the existing tables,
+    // and any tables being preloaded may no longer be in use afterwards
+
+    tablebasesAwaitInit();
+
+    pthread_mutex_lock(&SyzygyLock);
+    __atomic_store_n(&TB_PUBLISHED, 0, __ATOMIC_RELEASE);
+    tablebasesStopPreload();
+    snprintf(SyzygyPath, sizeof(SyzygyPath), "%s", path);
+    pthread_mutex_unlock(&SyzygyLock);
+
+    SyzygyInitRunning = !pthread_create(&SyzygyInit, NULL, &initTablebases, NULL);
+}
+
+void tablebasesSetPreload(const char *selection) {
+
+    pthread_mutex_lock(&SyzygyLock);
+    tablebasesStopPreload();
+    snprintf(SyzygyPreload, sizeof(SyzygyPreload), "%s", selection);
+    tablebasesStartPreload();
+    pthread_mutex_unlock(&SyzygyLock);
+}
+
+void tablebasesAwaitInit() {
+
+    if (SyzygyInitRunning)
+        pthread_join(SyzygyInit, NULL);
+
+    SyzygyInitRunning = 0;
+}
+
+static int preloadSelected(const char *table) {
+
+    // The selection is either the most pieces in any table to preload,
+    // or a list of table names separated by spaces or commas like KRPvKR
+
+    char copy[1024], *ptr = NULL;
+
+    if (isdigit(SyzygyPreload[0]))
+        return (int) strlen(table) - 1 <= atoi(SyzygyPreload);
+
+    snprintf(copy, sizeof(copy), "%s", SyzygyPreload);
+
+    for (char *token = strtok_r(copy, " ,", &ptr); token; token = strtok_r(NULL, " ,", &ptr))
+        if (!strcmp(token, table)) return 1;
+
+    return 0;
+}
+
+static void preloadAddFile(const char *directory, const char *name, int *size) {
+
+    // Only WDL and DTZ tables are ever probed by Ethereal
+    const char *suffix = strrchr(name, '.');
+    char table[64];
+
+    if (   suffix == NULL
+        || (strcmp(suffix, ".rtbw") && strcmp(suffix, ".rtbz"))
+        || suffix - name >= (int) sizeof(table))
+        return;
+
+    snprintf(table, sizeof(table), "%.*s", (int) (suffix - name), name);
+    if (!preloadSelected(table)) return;
+
+    if (Preload.count == *size)
+        Preload.files = realloc(Preload.files, sizeof(char*) * (*size = MAX(64, 2 * *size)));
+
+    Preload.files[Preload.count] = malloc(strlen(directory) + strlen(name) + 2);
+    sprintf(Preload.files[Preload.count++], "%s/%s", directory, name);
+}
+
+static void preloadFindFiles() {
+
+    // Walk each directory of the SyzygyPath, which are separated in
+    // the same way that Pyrrhic expects when calling tb_init()
+
+    char copy[4096], *ptr = NULL;
+    int size = 0;
+
+    snprintf(copy, sizeof(copy), "%s", SyzygyPath);
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    for (char *dir = strtok_r(copy, ";", &ptr); dir; dir = strtok_r(NULL, ";", &ptr)) {
+
+        WIN32_FIND_DATAA found;
+        char pattern[4096];
+        snprintf(pattern, sizeof(pattern), "%s/*", dir);
+
+        HANDLE handle = FindFirstFileA(pattern, &found);
+        if (handle == INVALID_HANDLE_VALUE) continue;
+
+        do preloadAddFile(dir, found.cFileName, &size);
+        while (FindNextFileA(handle, &found));
+
+        FindClose(handle);
+    }
+
+#else
+
+    for (char *dir = strtok_r(copy, ":", &ptr); dir; dir = strtok_r(NULL, ":", &ptr)) {
+
+        DIR *handle = opendir(dir);
+        struct dirent *found;
+        if (handle == NULL) continue;
+
+        while ((found = readdir(handle)) != NULL)
+            preloadAddFile(dir, found->d_name, &size);
+
+        closedir(handle);
+    }
+
+#endif
+}
+
+static uint64_t preloadFile(int index) {
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    // Without mmap() we simply read through the file, which
+    // leaves it in the page cache for when Pyrrhic maps it
+
+    char *buffer;
+    uint64_t bytes = 0ull;
+    size_t read;
+
+    FILE *fin = fopen(Preload.files[index], "rb");
+    if (fin == NULL) return 0ull;
+
+    buffer = malloc(TB_PRELOAD_CHUNK);
+
+    while (!Preload.stop && (read = fread(buffer, 1, TB_PRELOAD_CHUNK, fin)) > 0)
+        bytes += read;
+
+    free(buffer); fclose(fin);
+    return Preload.sizes[index] = bytes;
+
+#else
+
+    // Map the table ourselves, and ask for read-ahead across the whole
+    // file, before touching every page to wait on the I/O. This is done
+    // a chunk at a time, rather than with MAP_POPULATE, so that a new
+    // SyzygyPath or SyzygyPreload is able to interrupt a large table
+
+    struct stat info;
+    const uint64_t page = sysconf(_SC_PAGESIZE);
+    volatile uint8_t sum = 0;
+    uint64_t resident = 0ull;
+    unsigned char *vec;
+    uint8_t *data;
+
+    int fd = open(Preload.files[index], O_RDONLY);
+    if (fd == -1) return 0ull;
+
+    if (fstat(fd, &info) || info.st_size == 0) { close(fd); return 0ull; }
+
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) return 0ull;
+
+    Preload.maps[index]  = data;
+    Preload.sizes[index] = info.st_size;
+    madvise(data, info.st_size, MADV_WILLNEED);
+
+    for (uint64_t chunk = 0; chunk < (uint64_t) info.st_size && !Preload.stop; chunk += TB_PRELOAD_CHUNK)
+        for (uint64_t i = chunk; i < MIN(chunk + TB_PRELOAD_CHUNK, (uint64_t) info.st_size); i += page)
+            sum += data[i];
+
+    // Measure how much of the table actually made it into memory
+    vec = malloc((info.st_size + page - 1) / page);
+
+    if (!mincore(data, info.st_size, (void*) vec))
+        for (uint64_t i = 0; i < (info.st_size + page - 1) / page; i++)
+            resident += (vec[i] & 1) * page;
+
+    free(vec);
+    return MIN(resident, (uint64_t) info.st_size);
+
+#endif
+}
+
+static void preloadReport(const char *status) {
+    printf("info string SyzygyPreload %s %d of %d files %d of %d MB resident in %d ms\n",
+        status, Preload.finished, Preload.count, (int) (Preload.resident >> 20),
+        (int) (Preload.bytes >> 20), (int) (getRealTime() - Preload.start));
+    fflush(stdout);
+}
+
+static void *preloadWorker(void *unused) {
+
+    (void) unused;
+
+    while (1) {
+
+        pthread_mutex_lock(&Preload.lock);
+        int index = Preload.next++;
+        pthread_mutex_unlock(&Preload.lock);
+
+        if (index >= Preload.count || Preload.stop) break;
+
+        uint64_t resident = preloadFile(index);
+
+        pthread_mutex_lock(&Preload.lock);
+
+        Preload.finished += 1;
+        Preload.resident += resident;
+        Preload.bytes    += Preload.sizes[index];
+
+        // Report progress periodically, unless we are being stopped
+        if (!Preload.stop && Preload.finished == Preload.count)
+            preloadReport("finished");
+
+        else if (!Preload.stop && getRealTime() - Preload.reported >= TB_PRELOAD_TIMER_MS)
+            Preload.reported = getRealTime(), preloadReport("loaded");
+
+        pthread_mutex_unlock(&Preload.lock);
+    }
+
+    return NULL;
+}
+
+void tablebasesStartPreload() {
+
+    // Nothing to do without both a path and a selection of tables,
+    // or while Pyrrhic is still being initialized in the background
+    if (!SyzygyPath[0] || !SyzygyPreload[0] || !tablebasesLargest())
+        return;
+
+    preloadFindFiles();
+    if (!Preload.count) return;
+
+    Preload.maps  = calloc(Preload.count, sizeof(void*));
+    Preload.sizes = calloc(Preload.count, sizeof(uint64_t));
+    Preload.start = Preload.reported = getRealTime();
+    Preload.nthreads = MIN(TB_PRELOAD_THREADS, Preload.count);
+    pthread_mutex_init(&Preload.lock, NULL);
+
+    printf("info string SyzygyPreload started for %d files\n", Preload.count);
+    fflush(stdout);
+
+    for (int i = 0; i < Preload.nthreads; i++)
+        pthread_create(&Preload.threads[i], NULL, &preloadWorker, NULL);
+}
+
+void tablebasesStopPreload() {
+
+    if (!Preload.count) return;
+
+    Preload.stop = 1;
+    for (int i = 0; i < Preload.nthreads; i++)
+        pthread_join(Preload.threads[i], NULL);
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    for (int i = 0; i < Preload.count; i++)
+        if (Preload.maps[i]) munmap(Preload.maps[i], Preload.sizes[i]);
+#endif
+
+    for (int i = 0; i < Preload.count; i++)
+        free(Preload.files[i]);
+
+    free(Preload.files); free(Preload.maps); free(Preload.sizes);
+    pthread_mutex_destroy(&Preload.lock);
+    memset(&Preload, 0, sizeof(TBPreload));
 }
@@ -20,7 +20,41 @@
 
 #include "types.h"
 
+#include <pthread.h>
 #include <stdint.h>
 
+enum {
+    TB_CACHE_KEY_SIZE = 12,
+    TB_CACHE_MASK     = 0xFFF,
+    TB_CACHE_SIZE     = 1 << TB_CACHE_KEY_SIZE,
+};
+
+enum {
+    TB_PRELOAD_THREADS  = 4,
+    TB_PRELOAD_CHUNK    = 16 << 20,
+    TB_PRELOAD_TIMER_MS = 1000,
+};
+
+typedef uint64_t TBEntry;
+typedef TBEntry TBTable[TB_CACHE_SIZE];
+
+struct TBPreload {
+    char **files;
+    void **maps;
+    uint64_t *sizes;
+    int count, next, finished, nthreads;
+    uint64_t bytes, resident;
+    double start, reported;
+    volatile int stop;
+    pthread_t threads[TB_PRELOAD_THREADS];
+    pthread_mutex_t lock;
+};
+
 int tablebasesProbeDTZ(Board *board, Limits *limits, uint16_t *best, uint16_t *ponder);
-unsigned tablebasesProbeWDL(Board *board, int depth, int height);
+unsigned tablebasesProbeWDL(Thread *thread, Board *board, int depth, int height);
+
+void tablebasesSetPath(const char *path);
+void tablebasesSetPreload(const char *selection);
+void tablebasesAwaitInit();
+void tablebasesStartPreload();
+void tablebasesStopPreload();
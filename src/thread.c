@@ -19,6 +19,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32) || defined(_WIN64)
+    #include <malloc.h>
+#endif
+
 #include "board.h"
 #include "evaluate.h"
 #include "history.h"
@@ -33,7 +37,16 @@ int ContemptComplexity  = 0;
 
 Thread* createThreadPool(int nthreads) {
 
-    Thread *threads = calloc(nthreads, sizeof(Thread));
+    // Threads hold cache-line aligned tables and counters, and the compiler
+    // is free to assume that alignment, so the pool itself must honour it
+
+#if defined(_WIN32) || defined(_WIN64)
+    Thread *threads = _aligned_malloc(nthreads * sizeof(Thread), 64);
+#else
+    Thread *threads = aligned_alloc(64, nthreads * sizeof(Thread));
+#endif
+
+    memset(threads, 0, nthreads * sizeof(Thread));
 
     for (int i = 0; i < nthreads; i++) {
 
@@ -51,6 +64,17 @@ Thread* createThreadPool(int nthreads) {
     return threads;
 }
 
+void deleteThreadPool(Thread *threads) {
+
+    resizeSearchTrace(threads, 0);
+
+#if defined(_WIN32) || defined(_WIN64)
+    _aligned_free(threads);
+#else
+    free(threads);
+#endif
+}
+
 void resetThreadPool(Thread *threads) {
 
     // Reset the per-thread tables, used for move ordering
@@ -61,6 +85,7 @@ void resetThreadPool(Thread *threads) {
 
         memset(&threads[i].evtable, 0, sizeof(EvalTable));
         memset(&threads[i].pktable, 0, sizeof(PKTable));
+        memset(&threads[i].tbtable, 0, sizeof(TBTable));
 
         memset(&threads[i].killers, 0, sizeof(KillerTable));
         memset(&threads[i].cmtable, 0, sizeof(CounterMoveTable));
@@ -88,6 +113,11 @@ void newSearchThreadPool(Thread *threads, Board *board, Limits *limits, SearchIn
         threads[i].height    = 0;
         threads[i].nodes     = 0ull;
         threads[i].tbhits    = 0ull;
+        threads[i].ttprobes  = threads[i].tthits = 0ull;
+        threads[i].evprobes  = threads[i].evhits = 0ull;
+        threads[i].pkprobes  = threads[i].pkhits = 0ull;
+        threads[i].wdlprobes = threads[i].wdlhits = 0ull;
+        threads[i].trace.count = 0ull;
 
         memcpy(&threads[i].board, board, sizeof(Board));
         threads[i].contempt = board->turn == WHITE ? contempt : -contempt;
@@ -26,6 +26,8 @@
 #include "evalcache.h"
 
 #include "search.h"
+#include "searchtrace.h"
+#include "syzygy.h"
 #include "transposition.h"
 #include "types.h"
 
@@ -47,9 +49,17 @@ struct Thread {
 
     int contempt;
     int depth, seldepth, height;
-    uint64_t nodes, tbhits;
+    uint64_t ttSliceMask, ttSliceBase;
 
-    int *evalStack, _evalStack[STACK_SIZE];
+    ALIGN64 uint64_t nodes, tbhits;
+    uint64_t ttprobes, tthits;
+    uint64_t evprobes, evhits;
+    uint64_t pkprobes, pkhits;
+    uint64_t wdlprobes, wdlhits;
+
+    SearchTrace trace;
+
+    ALIGN64 int *evalStack, _evalStack[STACK_SIZE];
     uint16_t *moveStack, _moveStack[STACK_SIZE];
     int *pieceStack, _pieceStack[STACK_SIZE];
 
@@ -57,6 +67,7 @@ struct Thread {
 
     ALIGN64 EvalTable evtable;
     ALIGN64 PKTable pktable;
+    ALIGN64 TBTable tbtable;
 
     ALIGN64 KillerTable killers;
     ALIGN64 CounterMoveTable cmtable;
@@ -72,6 +83,7 @@ struct Thread {
 
 
 Thread* createThreadPool(int nthreads);
+void deleteThreadPool(Thread *threads);
 void resetThreadPool(Thread *threads);
 void newSearchThreadPool(Thread *threads, Board *board, Limits *limits, SearchInfo *info);
 uint64_t nodesSearchedThreadPool(Thread *threads);
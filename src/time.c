@@ -119,17 +119,34 @@ int terminateTimeManagment(SearchInfo *info) {
     return elapsedTime(info) > MIN(cutoff, info->maxAlloc);
 }
 
+static int exhaustedNodeBudget(Thread *thread) {
+
+    // A lone thread can check its own counter exactly. Otherwise the
+    // budget is shared by the pool, so sum the counters of all threads,
+    // but only once for every 1024 nodes, to limit the shared reads
+
+    const uint64_t limit = thread->limits->nodeLimit;
+
+    if (thread->nthreads == 1)
+        return thread->nodes >= limit;
+
+    return (thread->nodes & 1023) == 1023
+        &&  nodesSearchedThreadPool(thread->threads) >= limit;
+}
+
 int terminateSearchEarly(Thread *thread) {
 
     // Terminate the search early if the max usage time has passed.
     // Only check this once for every 1024 nodes examined, in case
     // the system calls are quite slow. Always be sure to avoid an
-    // early exit during a depth 1 search, to ensure a best move
+    // early exit during a depth 1 search, to ensure a best move.
+    // Node budgets are checked separately, and far more precisely
 
     const Limits *limits = thread->limits;
 
     return  thread->depth > 1
-        && (thread->nodes & 1023) == 1023
-        && (limits->limitedBySelf || limits->limitedByTime)
-        &&  elapsedTime(thread->info) >= thread->info->maxUsage;
+        && (   (limits->limitedByNodes && exhaustedNodeBudget(thread))
+            || (   (thread->nodes & 1023) == 1023
+                && (limits->limitedBySelf || limits->limitedByTime)
+                &&  elapsedTime(thread->info) >= thread->info->maxUsage));
 }
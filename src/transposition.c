@@ -78,9 +78,28 @@ void updateTT() {
 void clearTT() {
 
     // Wipe the Table in preperation for a new game. The
-    // Hash Mask is known to be one less than the size
+    // Hash Mask is known to be one less than the size. The
+    // age is reset too, since it factors into replacements
 
     memset(Table.buckets, 0, sizeof(TTBucket) * (Table.hashMask + 1u));
+    Table.generation = 0;
+}
+
+void sliceTT(int slices, int index, uint64_t *mask, uint64_t *base) {
+
+    // Confine a searcher to a private slice of the Table, by replacing
+    // the upper bits of the bucket index in each of its keys. Slices are
+    // the largest power of two such that every searcher is given one
+
+    uint64_t size = Table.hashMask + 1;
+    while (size * slices > Table.hashMask + 1 && size > 1) size /= 2;
+
+    *mask = Table.hashMask & ~(size - 1);
+    *base = (index * size) & Table.hashMask;
+}
+
+void clearSliceTT(uint64_t mask, uint64_t base) {
+    memset(&Table.buckets[base], 0, sizeof(TTBucket) * ((Table.hashMask & ~mask) + 1u));
 }
 
 int hashfullTT() {
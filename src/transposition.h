@@ -57,6 +57,8 @@ void initTT(uint64_t megabytes);
 int hashSizeMBTT();
 void updateTT();
 void clearTT();
+void sliceTT(int slices, int index, uint64_t *mask, uint64_t *base);
+void clearSliceTT(uint64_t mask, uint64_t base);
 int hashfullTT();
 int valueFromTT(int value, int height);
 int valueToTT(int value, int height);
@@ -18,11 +18,27 @@
 
 #ifdef TUNE
 
+#include <inttypes.h>
 #include <math.h>
+#include <omp.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32) || defined(_WIN64)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
 #include "bitboards.h"
 #include "board.h"
 #include "evaluate.h"
@@ -30,18 +46,20 @@
 #include "move.h"
 #include "search.h"
 #include "tuner.h"
+#include "tunerstream.h"
 #include "thread.h"
 #include "transposition.h"
 #include "types.h"
 #include "uci.h"
 #include "zobrist.h"
 
-// Internal Memory Managment
-TTuple* TupleStack;
-int TupleStackSize = STACKSIZE;
+// Internal Memory Managment, claimed per chunk of FENs
+_Thread_local TTuple* TupleStack;
+_Thread_local int TupleStackSize, TupleStackUsed;
 
 // Tap into evaluate()
-extern EvalTrace T, EmptyTrace;
+extern _Thread_local EvalTrace T;
+extern EvalTrace EmptyTrace;
 
 extern const int PawnValue;
 extern const int KnightValue;
@@ -118,52 +136,127 @@ extern const int ComplexityAdjustment;
 extern const int Tempo;
 
 
-void runTuner() {
+void runTuner(int fitOnly) {
 
-    TEntry *entries;
     TArray methods = {0};
-    TVector params = {0}, cparams = {0}, adagrad = {0};
-    Thread *thread = createThreadPool(1);
-    double K, error, rate = LRRATE;
-
-    const int tentryMB = (int)(NPOSITIONS * sizeof(TEntry) / (1 << 20));
-    const int ttupleMB = (int)(STACKSIZE  * sizeof(TTuple) / (1 << 20));
+    TVector cparams = {0};
+    Thread *threads = createThreadPool(omp_get_max_threads());
 
     setvbuf(stdout, NULL, _IONBF, 0);
     printf("Tuner will be tuning 2x%d Terms\n", NTERMS);
-    printf("Allocating Memory for Tuner Entries [%dMB]\n", tentryMB);
-    printf("Allocating Memory for Tuner Tuple Stack [%dMB]\n", ttupleMB);
     printf("Saving the current value for each Term as a starting point\n");
     printf("Marking each Term based on method { NORMAL, SAFETY, COMPLEXITY }\n\n");
 
-    entries    = calloc(NPOSITIONS, sizeof(TEntry));
-    TupleStack = calloc(STACKSIZE , sizeof(TTuple));
-
     initCurrentParameters(cparams);
     initMethodManager(methods);
-    initTunerEntries(entries, thread, methods);
-    K = computeOptimalK(entries);
 
-    for (int epoch = 0; epoch < MAXEPOCHS; epoch++) {
+    // Datasets which will not fit in memory are read from disk as needed
+    if (STREAMING) runStreamingTuner(threads, cparams, methods, fitOnly);
+    else           runMemoryTuner(threads, cparams, methods, fitOnly);
+}
+
+void runMemoryTuner(Thread *threads, TVector cparams, TArray methods, int fitOnly) {
+
+    TEntry *entries;
+    TTuple *tuples;
+    TState state = {0};
+    int *split = malloc(sizeof(int) * NPOSITIONS);
+    int *order = malloc(sizeof(int) * NPOSITIONS);
+    double K, error, validation = 0.0;
+
+    const int tentryMB = (int)(NPOSITIONS * sizeof(TEntry) / (1 << 20));
+    const int ttupleMB = (int)(STACKSIZE  * sizeof(TTuple) / (1 << 20));
+
+    printf("Allocating Memory for Tuner Entries [%dMB]\n", tentryMB);
+    printf("Allocating Memory for Tuner Tuple Stack [~%dMB]\n\n", ttupleMB);
+
+    // Reuse the entries of a prior run, when nothing has changed
+    const uint64_t layout  = hashTunerLayout(cparams, methods);
+    const uint64_t dataset = hashTunerDataset();
+
+    if (!(entries = loadTunerCache(&tuples, layout, dataset))) {
+        entries = calloc(NPOSITIONS, sizeof(TEntry));
+        tuples  = initTunerEntries(entries, threads, methods);
+        saveTunerCache(entries, tuples, layout, dataset);
+    }
+
+    K = computeOptimalK(entries, NPOSITIONS);
+    if (fitOnly) { free(split); free(order); return; }
+
+    // Hold out a random set of positions, which are never trained on
+    for (int i = 0; i < NPOSITIONS; i++) split[i] = i;
+    if (NTRAINING != NPOSITIONS) shuffleTunerOrder(split, NPOSITIONS, TUNER_SEED);
+
+    // Pick up where a previous run left off, or else start fresh
+    if (!loadTunerCheckpoint(&state, layout, dataset)) {
+        state.rate = LRRATE;
+        state.best = 1e9;
+    }
+
+    for (int epoch = state.epoch; epoch < MAXEPOCHS; epoch++) {
 
-        for (int batch = 0; batch < NPOSITIONS / BATCHSIZE; batch++) {
+        // Each epoch has its own shuffle, so a resumed run sees the same batches
+        memcpy(order, split, sizeof(int) * NPOSITIONS);
+        if (SHUFFLE) shuffleTunerOrder(order, NTRAINING, TUNER_SEED + epoch + 1);
 
+        for (int batch = 0; batch < NTRAINING / BATCHSIZE; batch++) {
             TVector gradient = {0};
-            computeGradient(entries, gradient, params, methods, K, batch);
+            computeGradient(entries, tuples, order + batch * BATCHSIZE, BATCHSIZE, gradient, state.params, K);
+            updateParameters(&state, gradient, K);
+        }
 
-            for (int i = 0; i < NTERMS; i++) {
-                adagrad[i][MG] += pow((K / 200.0) * gradient[i][MG] / BATCHSIZE, 2.0);
-                adagrad[i][EG] += pow((K / 200.0) * gradient[i][EG] / BATCHSIZE, 2.0);
-                params[i][MG] += (K / 200.0) * (gradient[i][MG] / BATCHSIZE) * (rate / sqrt(1e-8 + adagrad[i][MG]));
-                params[i][EG] += (K / 200.0) * (gradient[i][EG] / BATCHSIZE) * (rate / sqrt(1e-8 + adagrad[i][EG]));
-            }
+        error = tunedEvaluationErrors(entries, tuples, order, NTRAINING, state.params, K);
+
+        if (NTRAINING != NPOSITIONS)
+            validation = tunedEvaluationErrors(entries, tuples, order + NTRAINING, NPOSITIONS - NTRAINING, state.params, K);
+
+        if (finishTunerEpoch(&state, cparams, epoch, error, validation, NTRAINING != NPOSITIONS, layout, dataset))
+            break;
+    }
+
+    reportTunerBests(&state, cparams);
+    free(split); free(order);
+}
+
+int finishTunerEpoch(TState *state, TVector cparams, int epoch, double error, double validation, int validating, uint64_t layout, uint64_t dataset) {
+
+    if (epoch && epoch % LRSTEPRATE == 0) state->rate = state->rate / LRDROPRATE;
+    if (epoch % REPORTING == 0) printParameters(state->params, cparams);
+
+    if (!validating)
+        printf("\rEpoch [%d] Error = [%.9f], Rate = [%g]", epoch, error, state->rate);
+
+    else {
+
+        printf("\rEpoch [%d] Error = [%.9f], Validation = [%.9f], Rate = [%g]", epoch, error, validation, state->rate);
+
+        // Track the parameters which have generalized the best so far
+        if (validation < state->best) {
+            memcpy(state->bests, state->params, sizeof(TVector));
+            state->best = validation, state->stale = 0;
         }
 
-        error = tunedEvaluationErrors(entries, params, methods, K);
-        if (epoch && epoch % LRSTEPRATE == 0) rate = rate / LRDROPRATE;
-        if (epoch % REPORTING == 0) printParameters(params, cparams);
+        // Stop once the validation error has not improved for a while
+        else if (++state->stale >= PATIENCE) {
+            printf("\n\nStopping after %d epochs without improvement", PATIENCE);
+            return 1;
+        }
+    }
+
+    state->epoch = epoch + 1;
+    if (state->epoch % CHECKPOINT == 0)
+        saveTunerCheckpoint(state, layout, dataset);
+
+    return 0;
+}
+
+void reportTunerBests(TState *state, TVector cparams) {
 
-        printf("\rEpoch [%d] Error = [%.9f], Rate = [%g]", epoch, error, rate);
+    // Whether stopped early or not, finish with the parameters which have
+    // generalized the best. Without a validation set, there are none to show
+    if (state->best < 1e9) {
+        printf("\n\nBest Validation = [%.9f]\n", state->best);
+        printParameters(state->bests, cparams);
     }
 }
 
@@ -203,34 +296,343 @@ void initCoefficients(TVector coeffs) {
     }
 }
 
-void initTunerEntries(TEntry *entries, Thread *thread, TArray methods) {
+char *mapTunerFile(const char *fname, uint64_t *length) {
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    LARGE_INTEGER size;
+    HANDLE mapping;
+    char *data;
+
+    HANDLE file = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        return NULL;
+    }
+
+    *length = (uint64_t) size.QuadPart;
+    // Copy-on-write views may be written to, without writing to the file
+    mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    data = mapping ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+
+    // The view remains valid after closing both handles
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+
+    return data;
+
+#else
+
+    struct stat info;
+    char *data;
+    int fd = open(fname, O_RDONLY);
+
+    if (fd == -1 || fstat(fd, &info) == -1) {
+        if (fd != -1) close(fd);
+        return NULL;
+    }
+
+    *length = info.st_size;
+    // Private mappings may be written to, without writing to the file
+    data = mmap(NULL, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping remains valid after closing
+
+    return data == MAP_FAILED ? NULL : data;
+
+#endif
+}
+
+void unmapTunerFile(char *data, uint64_t length) {
+#if defined(_WIN32) || defined(_WIN64)
+    (void) length; UnmapViewOfFile(data);
+#else
+    munmap(data, length);
+#endif
+}
+
+TTuple *initTunerEntries(TEntry *entries, Thread *threads, TArray methods) {
+
+    TTuple *tuples, *stacks[TUNER_CHUNKS] = {0};
+    uint64_t sizes[TUNER_CHUNKS] = {0}, bases[TUNER_CHUNKS+1];
+    uint64_t length, starts[TUNER_CHUNKS+1];
+    int lines[TUNER_CHUNKS], firsts[TUNER_CHUNKS+1], completed = 0;
+    char *data = mapTunerFile("FENS", &length);
+
+    if (data == NULL) {
+        printf("Unable to open FENS\n");
+        exit(EXIT_FAILURE);
+    }
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    // Every chunk is read exactly once, so start paging in the whole file
+    madvise(data, length, MADV_WILLNEED);
+#endif
+
+    // Split the file into chunks of roughly equal size, where
+    // each chunk, aside from the first, begins on a new line
+
+    for (int i = 0; i <= TUNER_CHUNKS; i++) {
+
+        starts[i] = i * (length / TUNER_CHUNKS);
+        if (i == TUNER_CHUNKS) starts[i] = length;
+
+        // Files smaller than TUNER_CHUNKS bytes leave the leading chunks empty
+        while (starts[i] > 0 && i < TUNER_CHUNKS && starts[i] < length && data[starts[i]-1] != '\n')
+            starts[i]++;
+    }
+
+    // Count the lines in each chunk, so that every chunk knows
+    // the index of the first entry that it will be responsible for
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < TUNER_CHUNKS; i++) {
+        lines[i] = 0;
+        for (uint64_t j = starts[i]; j < starts[i+1]; j++)
+            lines[i] += data[j] == '\n' || j == length - 1;
+    }
+
+    for (int i = firsts[0] = 0; i < TUNER_CHUNKS; i++)
+        firsts[i+1] = firsts[i] + lines[i];
+
+    if (firsts[TUNER_CHUNKS] < NPOSITIONS) {
+        printf("FENS has %d lines, but NPOSITIONS is %d\n", firsts[TUNER_CHUNKS], NPOSITIONS);
+        exit(EXIT_FAILURE);
+    }
+
+    // Parse and evaluate each chunk in parallel. Every thread has its own
+    // Thread for evaluateBoard() and its own EvalTrace, while each chunk
+    // builds a Tuple Stack of its own for the entries it creates
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < TUNER_CHUNKS; i++) {
+
+        if (firsts[i] >= NPOSITIONS) continue;
+
+        int count = MIN(lines[i], NPOSITIONS - firsts[i]);
+        Thread *thread = &threads[omp_get_thread_num()];
+
+        stacks[i] = initTunerChunk(&entries[firsts[i]], count, data + starts[i], data + starts[i+1], thread, methods, &sizes[i]);
+
+        #pragma omp critical
+        {
+            completed += count;
+            printf("\rSetting up Entries from FENs [%8d of %8d]", completed, NPOSITIONS);
+        }
+    }
+
+    unmapTunerFile(data, length);
+
+    // Gather every chunk's Tuples into a single arena, which is what allows
+    // the entries to refer to their Tuples with just a 32-bit offset
+
+    for (int i = bases[0] = 0; i < TUNER_CHUNKS; i++)
+        bases[i+1] = bases[i] + sizes[i];
+
+    if (bases[TUNER_CHUNKS] > UINT32_MAX) {
+        printf("\nFENS has %"PRIu64" Tuples, which is too many to index\n", bases[TUNER_CHUNKS]);
+        exit(EXIT_FAILURE);
+    }
+
+    tuples = malloc(sizeof(TTuple) * MAX(1, bases[TUNER_CHUNKS]));
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < TUNER_CHUNKS; i++) {
+
+        if (firsts[i] >= NPOSITIONS) continue;
+
+        for (int j = firsts[i]; j < MIN(firsts[i+1], NPOSITIONS); j++)
+            entries[j].offset += bases[i];
+
+        memcpy(&tuples[bases[i]], stacks[i], sizeof(TTuple) * sizes[i]);
+        free(stacks[i]);
+    }
+
+    return tuples;
+}
+
+TTuple *initTunerChunk(TEntry *entries, int count, const char *data, const char *end, Thread *thread, TArray methods, uint64_t *ntuples) {
+
+    // Estimate the Tuple Stack needed, based on the global estimate
+    TupleStackUsed = 0;
+    TupleStackSize = MAX(1, (int)((double) count * NTERMS / 64));
+    TupleStack     = malloc(sizeof(TTuple) * TupleStackSize);
+
+    for (int i = 0; i < count; i++)
+        data = initTunerFEN(&entries[i], data, end, thread, methods);
+
+    *ntuples = TupleStackUsed;
+    return TupleStack;
+}
+
+const char *initTunerFEN(TEntry *entry, const char *data, const char *end, Thread *thread, TArray methods) {
 
     char line[256];
-    FILE *fin = fopen("FENS", "r");
 
-    for (int i = 0; i < NPOSITIONS; i++) {
+    // Copy out the line, since the mapped file is not terminated, and
+    // the final line of the file may not end with a newline either
+    const char *newline = memchr(data, '\n', end - data);
+    int size = (int)((newline ? newline : end) - data);
+    snprintf(line, sizeof(line), "%.*s", MIN(size, 255), data);
+
+    // Find the result { W, L, D } => { 1.0, 0.0, 0.5 }
+    if      (strstr(line, "[1.0]")) entry->result = 2;
+    else if (strstr(line, "[0.0]")) entry->result = 0;
+    else if (strstr(line, "[0.5]")) entry->result = 1;
+    else    {printf("Cannot Parse %s\n", line); exit(EXIT_FAILURE);}
 
-        if (fgets(line, 256, fin) == NULL)
-            exit(EXIT_FAILURE);
+    // Set the board with the current FEN
+    boardFromFEN(&thread->board, line, 0);
 
-        // Find the result { W, L, D } => { 1.0, 0.0, 0.5 }
-        if      (strstr(line, "[1.0]")) entries[i].result = 1.0;
-        else if (strstr(line, "[0.0]")) entries[i].result = 0.0;
-        else if (strstr(line, "[0.5]")) entries[i].result = 0.5;
-        else    {printf("Cannot Parse %s\n", line); exit(EXIT_FAILURE);}
+    // Defer the setup to another function
+    initTunerEntry(entry, thread, &thread->board, methods);
 
-        // Set the board with the current FEN
-        boardFromFEN(&thread->board, line, 0);
+    return newline ? newline + 1 : end;
+}
+
+uint64_t hashTunerBytes(const void *data, uint64_t length, uint64_t seed) {
+
+    // A simple multiply and xorshift hash, taking eight bytes at a time,
+    // which is only used to detect changes to the inputs of the tuner
 
-        // Defer the setup to another function
-        initTunerEntry(&entries[i], thread, &thread->board, methods);
+    const uint8_t *bytes = data;
+    uint64_t hash = seed ^ (length * 0x9E3779B97F4A7C15ull), word;
 
-        // Occasional reporting for total completion
-        if ((i + 1) % 10000 == 0 || i == NPOSITIONS - 1)
-            printf("\rSetting up Entries from FENs [%8d of %8d]", i + 1, NPOSITIONS);
+    for (uint64_t i = 0; i < length; i += 8) {
+        word = 0ull; memcpy(&word, bytes + i, MIN(8ull, length - i));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+
+    return hash;
+}
+
+uint64_t hashTunerLayout(TVector cparams, TArray methods) {
+
+    // The entries depend on which terms are being tuned, their current
+    // values, the structures used to hold them, and on the evaluation
+    // itself. The version stands in for any changes to the evaluation
+
+    const uint64_t sizes[] = { NTERMS, sizeof(TEntry), sizeof(TTuple) };
+
+    uint64_t hash = hashTunerBytes(VERSION_ID, strlen(VERSION_ID), 0ull);
+    hash = hashTunerBytes(sizes, sizeof(sizes), hash);
+    hash = hashTunerBytes(methods, sizeof(TArray), hash);
+    return hashTunerBytes(cparams, sizeof(TVector), hash);
+}
+
+uint64_t hashTunerDataset() {
+
+    // Hash the chunks of FENS in parallel, and then combine them in order
+
+    uint64_t length, hashes[TUNER_CHUNKS];
+    char *data = mapTunerFile("FENS", &length);
+
+    if (data == NULL) {
+        printf("Unable to open FENS\n");
+        exit(EXIT_FAILURE);
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < TUNER_CHUNKS; i++) {
+        uint64_t start = i * (length / TUNER_CHUNKS);
+        uint64_t end   = i == TUNER_CHUNKS - 1 ? length : start + length / TUNER_CHUNKS;
+        hashes[i] = hashTunerBytes(data + start, end - start, i);
+    }
+
+    unmapTunerFile(data, length);
+    return hashTunerBytes(hashes, sizeof(hashes), NPOSITIONS);
+}
+
+TEntry *loadTunerCache(TTuple **tuples, uint64_t layout, uint64_t dataset) {
+
+    TCacheHeader header;
+    uint64_t length;
+    TEntry *entries;
+    char *data;
+
+    FILE *fin = fopen(TUNER_CACHE, "rb");
+
+    if (fin == NULL) return NULL;
+
+    // Only accept a cache from the same version, layout, and dataset
+    if (   fread(&header, sizeof(TCacheHeader), 1, fin) != 1
+        || memcmp(header.magic, TUNER_CACHE_MAGIC, sizeof(header.magic))
+        || header.version    != TUNER_CACHE_VERSION
+        || header.layout     != layout
+        || header.dataset    != dataset
+        || header.npositions != NPOSITIONS) {
+        printf("Ignoring the stale %s\n", TUNER_CACHE);
+        fclose(fin);
+        return NULL;
     }
 
     fclose(fin);
+
+    if ((data = mapTunerFile(TUNER_CACHE, &length)) == NULL)
+        return NULL;
+
+    // A truncated cache would fault when read, so verify the size first
+    if (length !=  sizeof(TCacheHeader)
+                 + sizeof(TEntry) * (uint64_t) NPOSITIONS
+                 + sizeof(TTuple) * header.ntuples) {
+        printf("Ignoring the truncated %s\n", TUNER_CACHE);
+        unmapTunerFile(data, length);
+        return NULL;
+    }
+
+    // Entries refer to Tuples by offsets, so neither needs any fixing up
+    entries = (TEntry*) (data + sizeof(TCacheHeader));
+    *tuples = (TTuple*) (entries + NPOSITIONS);
+
+    // Every Entry's Tuples must lie within the arena
+    for (int i = 0; i < NPOSITIONS; i++) {
+        if ((uint64_t) entries[i].offset + entries[i].ntuples > header.ntuples) {
+            printf("Ignoring the corrupted %s\n", TUNER_CACHE);
+            unmapTunerFile(data, length);
+            return NULL;
+        }
+    }
+
+    printf("Loaded %d Entries and %"PRIu64" Tuples from %s\n", NPOSITIONS, header.ntuples, TUNER_CACHE);
+
+    return entries;
+}
+
+void saveTunerCache(TEntry *entries, TTuple *tuples, uint64_t layout, uint64_t dataset) {
+
+    TCacheHeader header = {0};
+    FILE *fout = fopen(TUNER_CACHE ".tmp", "wb");
+
+    if (fout == NULL) {
+        printf("\nUnable to create %s\n", TUNER_CACHE);
+        return;
+    }
+
+    memcpy(header.magic, TUNER_CACHE_MAGIC, sizeof(header.magic));
+    header.version    = TUNER_CACHE_VERSION;
+    header.layout     = layout;
+    header.dataset    = dataset;
+    header.npositions = NPOSITIONS;
+
+    for (int i = 0; i < NPOSITIONS; i++)
+        header.ntuples += entries[i].ntuples;
+
+    // The entries, followed by the arena of Tuples which they index
+    int written = fwrite(&header, sizeof(TCacheHeader), 1, fout) == 1
+               && fwrite(entries, sizeof(TEntry), NPOSITIONS, fout) == (size_t) NPOSITIONS
+               && fwrite(tuples, sizeof(TTuple), header.ntuples, fout) == header.ntuples
+               && !ferror(fout);
+
+    // Only publish a complete cache, so a short write can never leave a bad one
+    if (fclose(fout) == 0 && written && rename(TUNER_CACHE ".tmp", TUNER_CACHE) == 0)
+        printf("\nSaved %d Entries and %"PRIu64" Tuples to %s", NPOSITIONS, header.ntuples, TUNER_CACHE);
+
+    else {
+        printf("\nUnable to write %s\n", TUNER_CACHE);
+        remove(TUNER_CACHE ".tmp");
+    }
 }
 
 void initTunerEntry(TEntry *entry, Thread *thread, Board *board, TArray methods) {
@@ -241,9 +643,6 @@ void initTunerEntry(TEntry *entry, Thread *thread, Board *board, TArray methods)
               + 1 * popcount(board->pieces[BISHOP])
               + 1 * popcount(board->pieces[KNIGHT]);
 
-    // Save time by computing phase scalars now
-    entry->pfactors[MG] = 0 + phase / 24.0;
-    entry->pfactors[EG] = 1 - phase / 24.0;
     entry->phase = phase;
 
     // Save a white POV static evaluation
@@ -258,7 +657,7 @@ void initTunerEntry(TEntry *entry, Thread *thread, Board *board, TArray methods)
     // Save some of the evaluation modifiers
     entry->eval        = T.eval;
     entry->complexity  = T.complexity;
-    entry->sfactor     = T.factor / (double) SCALE_NORMAL;
+    entry->sfactor     = T.factor / (float) SCALE_NORMAL;
     entry->turn        = board->turn;
 
     // Save the Linear version of King Safety
@@ -268,90 +667,181 @@ void initTunerEntry(TEntry *entry, Thread *thread, Board *board, TArray methods)
 
 void initTunerTuples(TEntry *entry, TVector coeffs, TArray methods) {
 
-    int ttupleMB, length = 0, tidx = 0;
+    int length = 0, tidx = 0;
+
+    // Sum up any actively used terms, counting each method separately
+    for (int method = 0; method < METHOD_NB; method++) {
 
-    // Sum up any actively used terms
-    for (int i = 0; i < NTERMS; i++)
-        length += (methods[i] == NORMAL &&  coeffs[i][WHITE] - coeffs[i][BLACK] != 0.0)
-               || (methods[i] != NORMAL && (coeffs[i][WHITE] != 0.0 || coeffs[i][BLACK] != 0.0));
+        entry->mtuples[method] = 0;
 
-    // Allocate additional memory if needed
-    if (length > TupleStackSize) {
-        TupleStackSize = STACKSIZE;
-        TupleStack = calloc(STACKSIZE, sizeof(TTuple));
-        ttupleMB = STACKSIZE  * sizeof(TTuple) / (1 << 20);
-        printf(" Allocating Tuner Tuples [%dMB]\n", ttupleMB);
+        for (int i = 0; i < NTERMS; i++)
+            entry->mtuples[method] += methods[i] == method
+                && (   (method == NORMAL &&  coeffs[i][WHITE] - coeffs[i][BLACK] != 0.0)
+                    || (method != NORMAL && (coeffs[i][WHITE] != 0.0 || coeffs[i][BLACK] != 0.0)));
+
+        length += entry->mtuples[method];
+    }
+
+    // Grow the Tuple Stack for this chunk if needed
+    if (TupleStackUsed + length > TupleStackSize) {
+        TupleStackSize = MAX(2 * TupleStackSize, TupleStackUsed + length);
+        TupleStack = realloc(TupleStack, sizeof(TTuple) * TupleStackSize);
     }
 
     // Claim part of the Tuple Stack
-    entry->tuples   = TupleStack;
+    entry->offset   = TupleStackUsed;
     entry->ntuples  = length;
-    TupleStack     += length;
-    TupleStackSize -= length;
-
-    // Finally setup each of our TTuples
-    for (int i = 0; i < NTERMS; i++)
-        if (   (methods[i] == NORMAL &&  coeffs[i][WHITE] - coeffs[i][BLACK] != 0.0)
-            || (methods[i] != NORMAL && (coeffs[i][WHITE] != 0.0 || coeffs[i][BLACK] != 0.0)))
-            entry->tuples[tidx++] = (TTuple) { i, coeffs[i][WHITE], coeffs[i][BLACK] };
+    TupleStackUsed += length;
+
+    // Finally setup each of our TTuples, grouped by method
+    for (int method = 0; method < METHOD_NB; method++)
+        for (int i = 0; i < NTERMS; i++)
+            if (   methods[i] == method
+                && (   (method == NORMAL &&  coeffs[i][WHITE] - coeffs[i][BLACK] != 0.0)
+                    || (method != NORMAL && (coeffs[i][WHITE] != 0.0 || coeffs[i][BLACK] != 0.0))))
+                TupleStack[entry->offset + tidx++] = (TTuple) { i, coeffs[i][WHITE], coeffs[i][BLACK] };
 }
 
 
-double computeOptimalK(TEntry *entries) {
+double computeOptimalK(TEntry *entries, int length) {
 
-    double start = -10, end = 10, step = 1;
-    double curr = start, error, best = staticEvaluationErrors(entries, start);
+    double K, error, lower, upper;
+    int count = MIN(length, KSAMPLES);
+    TEntry *sample = entries;
+    uint64_t seed = TUNER_SEED;
 
-    printf("\n\nComputing optimal K\n");
+    printf("\n\nComputing optimal K from %d of %d Positions\n", count, length);
 
-    for (int i = 0; i < KPRECISION; i++) {
+    // Take one position at random from each of count equal strata
+    if (count < length) {
 
-        curr = start - step;
-        while (curr < end) {
-            curr = curr + step;
-            error = staticEvaluationErrors(entries, curr);
-            if (error <= best)
-                best = error, start = curr;
+        sample = malloc(sizeof(TEntry) * count);
+
+        for (int i = 0; i < count; i++) {
+            int start = partitionStartOf(length, count, i);
+            int width = partitionStartOf(length, count, i+1) - start;
+            sample[i] = entries[start + (int) (splitMix64(&seed) % width)];
         }
+    }
 
-        printf("Epoch [%d] K = [%.9f] E = [%.9f]\n", i, start, best);
+    K = goldenSectionK(sample, count, KMINIMUM, KMAXIMUM);
+    if (sample != entries) free(sample);
 
-        end   = start + step;
-        start = start - step;
-        step  = step  / 10.0;
+    // Verify against every position. With the error unimodal in K, being no
+    // worse than either neighbour places K within KDELTA of the true optimum
+
+    error = staticEvaluationErrors(entries, length, K);
+    lower = staticEvaluationErrors(entries, length, K - KDELTA);
+    upper = staticEvaluationErrors(entries, length, K + KDELTA);
+
+    if (lower < error || upper < error) {
+
+        double step = lower < error ? -KDELTA : KDELTA;
+        double prev = K, curr = K + step, next, ecurr = MIN(lower, upper), enext;
+
+        printf("Sampled K = [%.9f] was not optimal, refining with every Position\n", K);
+
+        // Walk downhill with a doubling step, until the error rises again,
+        // at which point the optimal K is bracketed by prev and next
+
+        while ((enext = staticEvaluationErrors(entries, length, next = curr + (step *= 2))) < ecurr)
+            prev = curr, curr = next, ecurr = enext;
+
+        K = goldenSectionK(entries, length, MIN(prev, next), MAX(prev, next));
+        error = staticEvaluationErrors(entries, length, K);
     }
 
-    printf("\n");
+    printf("Optimal K = [%.9f] E = [%.9f]\n\n", K, error);
 
-    return start;
+    return K;
 }
 
-double staticEvaluationErrors(TEntry *entries, double K) {
+double goldenSectionK(TEntry *entries, int length, double lower, double upper) {
 
-    double total = 0.0;
+    const double ratio = (sqrt(5.0) - 1.0) / 2.0;
 
-    #pragma omp parallel shared(total)
-    {
-        #pragma omp for schedule(static, NPOSITIONS / NPARTITIONS) reduction(+:total)
-        for (int i = 0; i < NPOSITIONS; i++)
-            total += pow(entries[i].result - sigmoid(K, entries[i].seval), 2);
+    double left  = upper - ratio * (upper - lower);
+    double right = lower + ratio * (upper - lower);
+    double eleft = staticEvaluationErrors(entries, length, left);
+    double eright = staticEvaluationErrors(entries, length, right);
+
+    // Each iteration keeps one of the two interior points, so that only one
+    // new evaluation is needed to shrink the bracket by the golden ratio
+
+    while (upper - lower > KPRECISION) {
+
+        if (eleft <= eright) {
+            upper = right, right = left, eright = eleft;
+            left  = upper - ratio * (upper - lower);
+            eleft = staticEvaluationErrors(entries, length, left);
+        }
+
+        else {
+            lower = left, left = right, eleft = eright;
+            right = lower + ratio * (upper - lower);
+            eright = staticEvaluationErrors(entries, length, right);
+        }
     }
 
-    return total / (double) NPOSITIONS;
+    return (lower + upper) / 2.0;
 }
 
-double tunedEvaluationErrors(TEntry *entries, TVector params, TArray methods, double K) {
+double staticEvaluationErrors(TEntry *entries, int length, double K) {
 
-    double total = 0.0;
+    double totals[NPARTITIONS], total = 0.0;
 
-    #pragma omp parallel shared(total)
-    {
-        #pragma omp for schedule(static, NPOSITIONS / NPARTITIONS) reduction(+:total)
-        for (int i = 0; i < NPOSITIONS; i++)
-            total += pow(entries[i].result - sigmoid(K, linearEvaluation(&entries[i], params, methods, NULL)), 2);
+    #pragma omp parallel for schedule(dynamic)
+    for (int p = 0; p < NPARTITIONS; p++) {
+
+        double partial = 0.0;
+
+        for (int i = partitionStart(length, p); i < partitionStart(length, p+1); i++)
+            partial += pow(entries[i].result / 2.0 - sigmoid(K, entries[i].seval), 2);
+
+        totals[p] = partial;
     }
 
-    return total / (double) NPOSITIONS;
+    for (int p = 0; p < NPARTITIONS; p++)
+        total += totals[p];
+
+    return total / (double) length;
+}
+
+double tunedEvaluationErrors(TEntry *entries, TTuple *tuples, int *order, int length, TVector params, double K) {
+
+    double totals[NPARTITIONS], total = 0.0;
+    TParams packed;
+
+    packParameters(params, packed);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int p = 0; p < NPARTITIONS; p++) {
+
+        double partial = 0.0;
+
+        for (int i = partitionStart(length, p); i < partitionStart(length, p+1); i++)
+            partial += pow(entries[order[i]].result / 2.0 - sigmoid(K, linearEvaluation(&entries[order[i]], tuples, packed, NULL)), 2);
+
+        totals[p] = partial;
+    }
+
+    for (int p = 0; p < NPARTITIONS; p++)
+        total += totals[p];
+
+    return total / (double) length;
+}
+
+int partitionStart(int length, int partition) {
+
+    // Partitions are fixed by the length alone, never by the number of
+    // threads, and are always summed in order. Floating point addition is
+    // not associative, so this is what makes every result reproducible
+
+    return partitionStartOf(length, NPARTITIONS, partition);
+}
+
+int partitionStartOf(int length, int partitions, int partition) {
+    return (int) ((int64_t) length * partition / partitions);
 }
 
 double sigmoid(double K, double E) {
@@ -359,31 +849,123 @@ double sigmoid(double K, double E) {
 }
 
 
-double linearEvaluation(TEntry *entry, TVector params, TArray methods, TGradientData *data) {
+void packParameters(TVector params, TParams packed) {
+
+    // Convert to the precision used by the kernels, once per batch
+
+    for (int i = 0; i < NTERMS; i++) {
+        packed[i][MG] = (tfloat) params[i][MG];
+        packed[i][EG] = (tfloat) params[i][EG];
+    }
+}
+
+void sumTuples(const TTuple *tuples, int length, TParams params, double sums[4]) {
+
+    // Compute { SUM(wcoeff * MG), SUM(bcoeff * MG), SUM(wcoeff * EG), SUM(bcoeff * EG) }
+    // for a run of tuples. Each TTuple packs into a single 32-bit lane as { index, wcoeff,
+    // bcoeff }, which is split apart with shifts, before gathering both parameters
+
+    int i = 0;
+    sums[0] = sums[1] = sums[2] = sums[3] = 0.0;
+
+#if defined(__AVX2__) && defined(__FMA__) && TUNEFLOAT
+
+    __m256 wmg = _mm256_setzero_ps(), bmg = _mm256_setzero_ps();
+    __m256 weg = _mm256_setzero_ps(), beg = _mm256_setzero_ps();
+
+    for (; i + 8 <= length; i += 8) {
+
+        __m256i packed = _mm256_loadu_si256((const __m256i*) &tuples[i]);
+        __m256i offset = _mm256_slli_epi32(_mm256_and_si256(packed, _mm256_set1_epi32(0xFFFF)), 1);
+        __m256  wcoeff = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(packed, 8), 24));
+        __m256  bcoeff = _mm256_cvtepi32_ps(_mm256_srai_epi32(packed, 24));
+
+        __m256 mg = _mm256_i32gather_ps(&params[0][MG], offset, 4);
+        __m256 eg = _mm256_i32gather_ps(&params[0][EG], offset, 4);
+
+        wmg = _mm256_fmadd_ps(wcoeff, mg, wmg); bmg = _mm256_fmadd_ps(bcoeff, mg, bmg);
+        weg = _mm256_fmadd_ps(wcoeff, eg, weg); beg = _mm256_fmadd_ps(bcoeff, eg, beg);
+    }
+
+    float lanes[4][8];
+    _mm256_storeu_ps(lanes[0], wmg); _mm256_storeu_ps(lanes[1], bmg);
+    _mm256_storeu_ps(lanes[2], weg); _mm256_storeu_ps(lanes[3], beg);
+
+    for (int j = 0; j < 4; j++)
+        for (int k = 0; k < 8; k++)
+            sums[j] += lanes[j][k];
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+    __m256d wmg = _mm256_setzero_pd(), bmg = _mm256_setzero_pd();
+    __m256d weg = _mm256_setzero_pd(), beg = _mm256_setzero_pd();
+
+    for (; i + 4 <= length; i += 4) {
+
+        __m128i packed = _mm_loadu_si128((const __m128i*) &tuples[i]);
+        __m128i offset = _mm_slli_epi32(_mm_and_si128(packed, _mm_set1_epi32(0xFFFF)), 1);
+        __m256d wcoeff = _mm256_cvtepi32_pd(_mm_srai_epi32(_mm_slli_epi32(packed, 8), 24));
+        __m256d bcoeff = _mm256_cvtepi32_pd(_mm_srai_epi32(packed, 24));
+
+        __m256d mg = _mm256_i32gather_pd(&params[0][MG], offset, 8);
+        __m256d eg = _mm256_i32gather_pd(&params[0][EG], offset, 8);
+
+        wmg = _mm256_fmadd_pd(wcoeff, mg, wmg); bmg = _mm256_fmadd_pd(bcoeff, mg, bmg);
+        weg = _mm256_fmadd_pd(wcoeff, eg, weg); beg = _mm256_fmadd_pd(bcoeff, eg, beg);
+    }
+
+    double lanes[4][4];
+    _mm256_storeu_pd(lanes[0], wmg); _mm256_storeu_pd(lanes[1], bmg);
+    _mm256_storeu_pd(lanes[2], weg); _mm256_storeu_pd(lanes[3], beg);
+
+    for (int j = 0; j < 4; j++)
+        for (int k = 0; k < 4; k++)
+            sums[j] += lanes[j][k];
+
+#endif
+
+    // Scalar fallback, which also handles any remaining tuples
+    for (; i < length; i++) {
+        sums[0] += tuples[i].wcoeff * params[tuples[i].index][MG];
+        sums[1] += tuples[i].bcoeff * params[tuples[i].index][MG];
+        sums[2] += tuples[i].wcoeff * params[tuples[i].index][EG];
+        sums[3] += tuples[i].bcoeff * params[tuples[i].index][EG];
+    }
+}
+
+void scatterTuples(const TTuple *tuples, int length, TVector gradient, double mgw, double mgb, double egw, double egb) {
+
+    // Every tuple in a group shares the same per-colour gradient scalars. AVX2
+    // lacks a scatter, but indices are unique within an entry, so this is free
+    // of any dependencies between iterations and of any branches on the method
+
+    for (int i = 0; i < length; i++) {
+        gradient[tuples[i].index][MG] += mgw * tuples[i].wcoeff + mgb * tuples[i].bcoeff;
+        gradient[tuples[i].index][EG] += egw * tuples[i].wcoeff + egb * tuples[i].bcoeff;
+    }
+}
+
+
+double linearEvaluation(TEntry *entry, TTuple *tuples, TParams params, TGradientData *data) {
 
     double sign, mixed;
     double midgame, endgame, wsafety[2], bsafety[2];
     double normal[PHASE_NB], safety[PHASE_NB], complexity;
-    double mg[METHOD_NB][COLOUR_NB] = {0}, eg[METHOD_NB][COLOUR_NB] = {0};
+    double sums[METHOD_NB][4];
 
     // Save any modifications for MG or EG for each evaluation type
-    for (int i = 0; i < entry->ntuples; i++) {
-        int index = entry->tuples[i].index;
-        mg[methods[index]][WHITE] += (double) entry->tuples[i].wcoeff * params[index][MG];
-        mg[methods[index]][BLACK] += (double) entry->tuples[i].bcoeff * params[index][MG];
-        eg[methods[index]][WHITE] += (double) entry->tuples[i].wcoeff * params[index][EG];
-        eg[methods[index]][BLACK] += (double) entry->tuples[i].bcoeff * params[index][EG];
-    }
+    for (int method = 0, offset = 0; method < METHOD_NB; offset += entry->mtuples[method++])
+        sumTuples(tuples + entry->offset + offset, entry->mtuples[method], params, sums[method]);
 
     // Grab the original "normal" evaluations and add the modified parameters
-    normal[MG] = (double) ScoreMG(entry->eval) + mg[NORMAL][WHITE] - mg[NORMAL][BLACK];
-    normal[EG] = (double) ScoreEG(entry->eval) + eg[NORMAL][WHITE] - eg[NORMAL][BLACK];
+    normal[MG] = (double) ScoreMG(entry->eval) + sums[NORMAL][0] - sums[NORMAL][1];
+    normal[EG] = (double) ScoreEG(entry->eval) + sums[NORMAL][2] - sums[NORMAL][3];
 
     // Grab the original "safety" evaluations and add the modified parameters
-    wsafety[MG] = (double) ScoreMG(entry->safety[WHITE]) + mg[SAFETY][WHITE];
-    wsafety[EG] = (double) ScoreEG(entry->safety[WHITE]) + eg[SAFETY][WHITE];
-    bsafety[MG] = (double) ScoreMG(entry->safety[BLACK]) + mg[SAFETY][BLACK];
-    bsafety[EG] = (double) ScoreEG(entry->safety[BLACK]) + eg[SAFETY][BLACK];
+    wsafety[MG] = (double) ScoreMG(entry->safety[WHITE]) + sums[SAFETY][0];
+    wsafety[EG] = (double) ScoreEG(entry->safety[WHITE]) + sums[SAFETY][2];
+    bsafety[MG] = (double) ScoreMG(entry->safety[BLACK]) + sums[SAFETY][1];
+    bsafety[EG] = (double) ScoreEG(entry->safety[BLACK]) + sums[SAFETY][3];
 
     // Remove the original "safety" evaluation that was double counted into the "normal" evaluation
     normal[MG] -= MIN(0, -ScoreMG(entry->safety[WHITE]) * fabs(ScoreMG(entry->safety[WHITE])) / 720.0)
@@ -396,7 +978,7 @@ double linearEvaluation(TEntry *entry, TVector params, TArray methods, TGradient
     safety[EG] = MIN(0, -wsafety[EG] / 20.0) - MIN(0, -bsafety[EG] / 20.0);
 
     // Grab the original "complexity" evaluation and add the modified parameters
-    complexity = (double) ScoreEG(entry->complexity) + eg[COMPLEXITY][WHITE];
+    complexity = (double) ScoreEG(entry->complexity) + sums[COMPLEXITY][2];
     sign       = (normal[EG] + safety[EG] > 0.0) - (normal[EG] + safety[EG] < 0.0);
 
     // Save this information since we need it to compute the gradients
@@ -415,55 +997,167 @@ double linearEvaluation(TEntry *entry, TVector params, TArray methods, TGradient
     return mixed + (entry->turn == WHITE ? Tempo : -Tempo);
 }
 
-void computeGradient(TEntry *entries, TVector gradient, TVector params, TArray methods, double K, int batch) {
+void computeGradient(TEntry *entries, TTuple *tuples, int *indices, int length, TVector gradient, TVector params, double K) {
+
+    // One slot for each partition of the batch, rather than for each thread
+    static TVector *slots = NULL;
+    if (slots == NULL) slots = malloc(sizeof(TVector) * NPARTITIONS);
+
+    TParams packed;
 
-    #pragma omp parallel shared(gradient)
+    packParameters(params, packed);
+
+    #pragma omp parallel
     {
-        TVector local = {0};
+        #pragma omp for schedule(dynamic)
+        for (int p = 0; p < NPARTITIONS; p++) {
 
-        #pragma omp for schedule(static, BATCHSIZE / NPARTITIONS)
-        for (int i = batch * BATCHSIZE; i < (batch + 1) * BATCHSIZE; i++)
-            updateSingleGradient(&entries[i], local, params, methods, K);
+            memset(slots[p], 0, sizeof(TVector));
 
-        for (int i = 0; i < NTERMS; i++) {
-            gradient[i][MG] += local[i][MG];
-            gradient[i][EG] += local[i][EG];
+            for (int i = partitionStart(length, p); i < partitionStart(length, p+1); i++)
+                updateSingleGradient(&entries[indices[i]], tuples, slots[p], packed, K);
         }
+
+        // Split the reduction by terms, so that it too scales with threads
+        #pragma omp for schedule(static)
+        for (int i = 0; i < NTERMS * PHASE_NB; i++)
+            for (int p = 0; p < NPARTITIONS; p++)
+                ((double*) gradient)[i] += ((double*) slots[p])[i];
     }
 }
 
-void updateSingleGradient(TEntry *entry, TVector gradient, TVector params, TArray methods, double K) {
+void updateSingleGradient(TEntry *entry, TTuple *tuples, TVector gradient, TParams params, double K) {
 
     TGradientData data;
-    double E = linearEvaluation(entry, params, methods, &data);
+    double E = linearEvaluation(entry, tuples, params, &data);
     double S = sigmoid(K, E);
-    double A = (entry->result - S) * S * (1 - S);
+    double A = (entry->result / 2.0 - S) * S * (1 - S);
 
-    double mgBase = A * entry->pfactors[MG];
-    double egBase = A * entry->pfactors[EG];
+    double mgBase = A * (0 + entry->phase / 24.0);
+    double egBase = A * (1 - entry->phase / 24.0);
 
     double complexitySign = (data.egeval > 0.0) - (data.egeval < 0.0);
+    int complexityActive  = data.complexity >= -fabs(data.egeval);
+    int endgameActive     = data.egeval == 0.0 || complexityActive;
+
+    const TTuple *normals      = tuples + entry->offset;
+    const TTuple *complexities = normals + entry->mtuples[NORMAL];
+    const TTuple *safeties     = complexities + entry->mtuples[COMPLEXITY];
+
+    // NORMAL terms contribute (wcoeff - bcoeff) to both phases
+    double normalEG = endgameActive ? egBase * entry->sfactor : 0.0;
+    scatterTuples(normals, entry->mtuples[NORMAL], gradient, mgBase, -mgBase, normalEG, -normalEG);
+
+    // COMPLEXITY terms only exist in the EG, and only for White
+    double complexityEG = complexityActive ? egBase * complexitySign * entry->sfactor : 0.0;
+    scatterTuples(complexities, entry->mtuples[COMPLEXITY], gradient, 0.0, 0.0, complexityEG, 0.0);
+
+    // SAFETY terms are scaled by the current safety of each side
+    double wsafetyEG = endgameActive ? -(egBase / 20.0) * (data.wsafetyeg > 0.0) : 0.0;
+    double bsafetyEG = endgameActive ?  (egBase / 20.0) * (data.bsafetyeg > 0.0) : 0.0;
+    scatterTuples(safeties, entry->mtuples[SAFETY], gradient,
+        -(mgBase / 360.0) * fmax(data.wsafetymg, 0), (mgBase / 360.0) * fmax(data.bsafetymg, 0), wsafetyEG, bsafetyEG);
+}
 
-    for (int i = 0; i < entry->ntuples; i++) {
+void updateParameters(TState *state, TVector gradient, double K) {
 
-        int index  = entry->tuples[i].index;
-        int wcoeff = entry->tuples[i].wcoeff;
-        int bcoeff = entry->tuples[i].bcoeff;
+    state->step++;
 
-        if (methods[index] == NORMAL)
-            gradient[index][MG] += mgBase * (wcoeff - bcoeff);
+    if (OPTIMIZER == ADAGRAD) {
 
-        if (methods[index] == NORMAL && (data.egeval == 0.0 || data.complexity >= -fabs(data.egeval)))
-            gradient[index][EG] += egBase * (wcoeff - bcoeff) * entry->sfactor;
+        for (int i = 0; i < NTERMS; i++) {
+            state->second[i][MG] += pow((K / 200.0) * gradient[i][MG] / BATCHSIZE, 2.0);
+            state->second[i][EG] += pow((K / 200.0) * gradient[i][EG] / BATCHSIZE, 2.0);
+            state->params[i][MG] += (K / 200.0) * (gradient[i][MG] / BATCHSIZE) * (state->rate / sqrt(1e-8 + state->second[i][MG]));
+            state->params[i][EG] += (K / 200.0) * (gradient[i][EG] / BATCHSIZE) * (state->rate / sqrt(1e-8 + state->second[i][EG]));
+        }
+    }
+
+    if (OPTIMIZER == ADAM) {
+
+        // Correct for the moments being biased towards their initial zeros
+        const double mcorrect = 1.0 - pow(ADAMBETA1, state->step);
+        const double vcorrect = 1.0 - pow(ADAMBETA2, state->step);
+
+        for (int i = 0; i < NTERMS; i++) {
+            for (int phase = MG; phase <= EG; phase++) {
+
+                double g = (K / 200.0) * gradient[i][phase] / BATCHSIZE;
+
+                state->first[i][phase]  = ADAMBETA1 * state->first[i][phase]  + (1.0 - ADAMBETA1) * g;
+                state->second[i][phase] = ADAMBETA2 * state->second[i][phase] + (1.0 - ADAMBETA2) * g * g;
+
+                state->params[i][phase] += state->rate * (state->first[i][phase] / mcorrect)
+                                         / (sqrt(state->second[i][phase] / vcorrect) + 1e-8);
+            }
+        }
+    }
+}
+
+void shuffleTunerOrder(int *order, int length, uint64_t seed) {
+
+    // Fisher-Yates, driven by a SplitMix64 generator of our own, so that
+    // each shuffle depends on nothing but its seed
+
+    for (int i = length - 1; i > 0; i--) {
+        int j = (int) (splitMix64(&seed) % (uint64_t) (i + 1));
+        int swap = order[i]; order[i] = order[j]; order[j] = swap;
+    }
+}
+
+uint64_t splitMix64(uint64_t *seed) {
+
+    uint64_t z = (*seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+int loadTunerCheckpoint(TState *state, uint64_t layout, uint64_t dataset) {
+
+    TState loaded;
+    FILE *fin = fopen(TUNER_CHECKPOINT, "rb");
+
+    if (fin == NULL) return 0;
+
+    // Only resume with the same terms, dataset, and optimizer
+    if (   fread(&loaded, sizeof(TState), 1, fin) != 1
+        || memcmp(loaded.magic, TUNER_CHECKPOINT_MAGIC, sizeof(loaded.magic))
+        || loaded.layout    != layout
+        || loaded.dataset   != dataset
+        || loaded.optimizer != OPTIMIZER) {
+        printf("Ignoring the stale %s\n\n", TUNER_CHECKPOINT);
+        fclose(fin);
+        return 0;
+    }
+
+    fclose(fin);
+
+    printf("Resuming from Epoch [%d] of %s\n\n", loaded.epoch, TUNER_CHECKPOINT);
+    *state = loaded;
+    return 1;
+}
+
+void saveTunerCheckpoint(TState *state, uint64_t layout, uint64_t dataset) {
+
+    FILE *fout = fopen(TUNER_CHECKPOINT ".tmp", "wb");
+
+    if (fout == NULL) {
+        printf("\nUnable to create %s\n", TUNER_CHECKPOINT);
+        return;
+    }
 
-        if (methods[index] == COMPLEXITY && data.complexity >= -fabs(data.egeval))
-            gradient[index][EG] += egBase * wcoeff * complexitySign * entry->sfactor;
+    memcpy(state->magic, TUNER_CHECKPOINT_MAGIC, sizeof(state->magic));
+    state->layout    = layout;
+    state->dataset   = dataset;
+    state->optimizer = OPTIMIZER;
 
-        if (methods[index] == SAFETY)
-            gradient[index][MG] += (mgBase / 360.0) * (fmax(data.bsafetymg, 0) * bcoeff - (fmax(data.wsafetymg, 0) * wcoeff));
+    int written = fwrite(state, sizeof(TState), 1, fout) == 1 && !ferror(fout);
 
-        if (methods[index] == SAFETY && (data.egeval == 0.0 || data.complexity >= -fabs(data.egeval)))
-            gradient[index][EG] += (egBase /  20.0) * ((data.bsafetyeg > 0.0) * bcoeff - (data.wsafetyeg > 0.0) * wcoeff);
+    // Only replace the last checkpoint once this one is complete
+    if (fclose(fout) != 0 || !written || rename(TUNER_CHECKPOINT ".tmp", TUNER_CHECKPOINT) != 0) {
+        printf("\nUnable to save %s\n", TUNER_CHECKPOINT);
+        remove(TUNER_CHECKPOINT ".tmp");
     }
 }
 
@@ -22,8 +22,16 @@
 
 #include "types.h"
 
-#define NPARTITIONS    (      64) // Total thread partitions
-#define KPRECISION     (      10) // Iterations for computing K
+#define NPARTITIONS    (     256) // Fixed partitions, reduced in order
+#define TUNER_CHUNKS   (    1024) // Chunks of FENS to setup in parallel
+#define TUNER_CACHE    "FENS.cache"   // Binary cache of Entries and Tuples
+#define KPRECISION     (    1e-9) // Final width of the bracket for K
+#define KSAMPLES       ( 1000000) // Positions sampled when computing K
+#define KMINIMUM       (   -10.0) // Lower bound when searching for K
+#define KMAXIMUM       (    10.0) // Upper bound when searching for K
+#define KDELTA         (   0.001) // Resolution for verifying K on every Position
+#define TUNEFLOAT      (       0) // Single precision in the evaluation kernels
+#define STREAMING      (       0) // Stream batches from disk, rather than memory
 #define PRETTYIFY      (       0) // Whether to format as if we tune everything
 #define REPORTING      (      50) // How often to print the new parameters
 
@@ -31,6 +39,17 @@
 #define LRDROPRATE     (    1.00) // Cut LR by this each LR-step
 #define LRSTEPRATE     (     250) // Cut LR after this many epochs
 
+#define OPTIMIZER      (    ADAM) // Either of ADAGRAD or ADAM
+#define ADAMBETA1      (   0.900) // Decay rate for Adam's first moment
+#define ADAMBETA2      (   0.999) // Decay rate for Adam's second moment
+
+#define SHUFFLE        (       1) // Shuffle the Training samples every epoch
+#define VALIDATION     (    0.05) // Fraction of samples held out for validation
+#define PATIENCE       (     100) // Stop after this many epochs without improving
+#define CHECKPOINT     (      10) // How often to save the state of the Tuner
+#define TUNER_CHECKPOINT "FENS.checkpoint"
+#define TUNER_SEED     (   0x5EED) // Seeds the validation split and the shuffles
+
 #define TuneNormal     (       0) // Flag to enable all Normals      (856)
 #define TuneSafety     (       0) // Flag to enable all Safeties     ( 44)
 #define TuneComplexity (       0) // Flag to enable all Complexities (  4)
@@ -41,6 +60,7 @@
 #define NPOSITIONS     (42487498) // Total Training samples in the book
 
 #define STACKSIZE ((int)((double) NPOSITIONS * NTERMS / 64))
+#define NTRAINING ((int)((double) NPOSITIONS * (1.0 - VALIDATION)))
 
 #define TunePawnValue                   (0 || TuneNormal)
 #define TuneKnightValue                 (0 || TuneNormal)
@@ -117,6 +137,8 @@
 
 enum { NORMAL, COMPLEXITY, SAFETY, METHOD_NB };
 
+enum { ADAGRAD, ADAM };
+
 typedef struct TTuple {
     uint16_t index;
     int8_t wcoeff;
@@ -124,12 +146,23 @@ typedef struct TTuple {
 } TTuple;
 
 typedef struct TEntry {
-    int ntuples, seval, phase, turn;
-    int eval, safety[COLOUR_NB], complexity;
-    double result, sfactor, pfactors[PHASE_NB];
-    TTuple *tuples;
+    int eval, safety[COLOUR_NB], complexity, seval;
+    uint32_t offset;             // Index of the first Tuple in the arena
+    float sfactor;               // Scale factor, as a fraction of SCALE_NORMAL
+    uint16_t ntuples;            // Total Tuples, which never exceeds NTERMS
+    uint16_t mtuples[METHOD_NB]; // Tuples grouped by method, in enum order
+    uint8_t phase, turn, result; // Result in halves, { L, D, W } => { 0, 1, 2 }
 } TEntry;
 
+#define TUNER_CACHE_MAGIC   ("ETUNECHE")
+#define TUNER_CACHE_VERSION (3)
+
+typedef struct TCacheHeader {
+    char magic[8];
+    uint64_t version, layout, dataset;
+    uint64_t npositions, ntuples;
+} TCacheHeader;
+
 typedef struct TGradientData {
     double egeval, complexity;
     double wsafetymg, bsafetymg;
@@ -140,23 +173,67 @@ typedef int TArray[NTERMS];
 
 typedef double TVector[NTERMS][PHASE_NB];
 
+#if TUNEFLOAT
+typedef float tfloat;
+#else
+typedef double tfloat;
+#endif
 
-void runTuner();
+typedef tfloat TParams[NTERMS][PHASE_NB];
+
+#define TUNER_CHECKPOINT_MAGIC ("ETUNECKP")
+
+typedef struct TState {
+    char magic[8];
+    uint64_t layout, dataset;
+    int optimizer, epoch, stale;
+    uint64_t step;      // Batches seen, for Adam's bias correction
+    double rate, best;  // Learning rate and best Validation error
+    TVector params, bests, first, second;
+} TState;
+
+
+void runTuner(int fitOnly);
+void runMemoryTuner(Thread *threads, TVector cparams, TArray methods, int fitOnly);
+int finishTunerEpoch(TState *state, TVector cparams, int epoch, double error, double validation, int validating, uint64_t layout, uint64_t dataset);
+void reportTunerBests(TState *state, TVector cparams);
 void initCurrentParameters(TVector cparams);
 void initMethodManager(TArray methods);
 void initCoefficients(TVector coeffs);
-void initTunerEntries(TEntry *entries, Thread *thread, TArray methods);
+char *mapTunerFile(const char *fname, uint64_t *length);
+void unmapTunerFile(char *data, uint64_t length);
+TTuple *initTunerEntries(TEntry *entries, Thread *threads, TArray methods);
+uint64_t hashTunerBytes(const void *data, uint64_t length, uint64_t seed);
+uint64_t hashTunerLayout(TVector cparams, TArray methods);
+uint64_t hashTunerDataset();
+TEntry *loadTunerCache(TTuple **tuples, uint64_t layout, uint64_t dataset);
+void saveTunerCache(TEntry *entries, TTuple *tuples, uint64_t layout, uint64_t dataset);
+TTuple *initTunerChunk(TEntry *entries, int count, const char *data, const char *end, Thread *thread, TArray methods, uint64_t *ntuples);
+const char *initTunerFEN(TEntry *entry, const char *data, const char *end, Thread *thread, TArray methods);
 void initTunerEntry(TEntry *entry, Thread *thread, Board *board, TArray methods);
 void initTunerTuples(TEntry *entry, TVector coeffs, TArray methods);
 
-double computeOptimalK(TEntry *entries);
-double staticEvaluationErrors(TEntry *entries, double K);
-double tunedEvaluationErrors(TEntry *entries, TVector params, TArray methods, double K);
+double computeOptimalK(TEntry *entries, int length);
+double goldenSectionK(TEntry *entries, int length, double lower, double upper);
+double staticEvaluationErrors(TEntry *entries, int length, double K);
+double tunedEvaluationErrors(TEntry *entries, TTuple *tuples, int *order, int length, TVector params, double K);
 double sigmoid(double K, double E);
-
-double linearEvaluation(TEntry *entry, TVector params, TArray methods, TGradientData *data);
-void computeGradient(TEntry *entries, TVector gradient, TVector params, TArray methods, double K, int batch);
-void updateSingleGradient(TEntry *entry, TVector gradient, TVector params, TArray methods, double K);
+int partitionStart(int length, int partition);
+int partitionStartOf(int length, int partitions, int partition);
+
+void packParameters(TVector params, TParams packed);
+void sumTuples(const TTuple *tuples, int length, TParams params, double sums[4]);
+void scatterTuples(const TTuple *tuples, int length, TVector gradient, double mgw, double mgb, double egw, double egb);
+
+double linearEvaluation(TEntry *entry, TTuple *tuples, TParams params, TGradientData *data);
+void computeGradient(TEntry *entries, TTuple *tuples, int *indices, int length, TVector gradient, TVector params, double K);
+void updateSingleGradient(TEntry *entry, TTuple *tuples, TVector gradient, TParams params, double K);
+
+void updateParameters(TState *state, TVector gradient, double K);
+void shuffleTunerOrder(int *order, int length, uint64_t seed);
+uint64_t splitMix64(uint64_t *seed);
+int loadTunerCheckpoint(TState *state, uint64_t layout, uint64_t dataset);
+void saveTunerCheckpoint(TState *state, uint64_t layout, uint64_t dataset);
 
 void printParameters(TVector params, TVector cparams);
 void print_0(char *name, TVector params, int i, char *S);
@@ -0,0 +1,400 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef TUNE
+
+#include <inttypes.h>
+#include <omp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "thread.h"
+#include "tuner.h"
+#include "tunerstream.h"
+#include "types.h"
+
+// Internal Memory Managment, claimed per chunk of FENs
+extern _Thread_local TTuple* TupleStack;
+extern _Thread_local int TupleStackSize, TupleStackUsed;
+
+static void *streamReader(void *arg) {
+    TStreamSlot *slot = arg;
+    readStreamBlock(slot->stream, slot->block, slot->buffer);
+    return NULL;
+}
+
+void runStreamingTuner(Thread *threads, TVector cparams, TArray methods, int fitOnly) {
+
+    TStream stream;
+    TState state = {0};
+    TEntry *entries, *sample;
+    int *split, *order, *identity, nfull, ntraining, nsample;
+    double K, error, validation = 0.0;
+
+    const uint64_t layout  = hashTunerLayout(cparams, methods);
+    const uint64_t dataset = hashTunerFile("FENS");
+
+    // Convert FENS into batches on disk, if not already done so
+    if (!openTunerStream(&stream, layout, dataset)) {
+        buildTunerStream(threads, methods, layout, dataset);
+        if (!openTunerStream(&stream, layout, dataset)) {
+            printf("Unable to open %s\n", TUNER_STREAM);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Only full blocks are trained on, which is all but possibly the last
+    nfull     = (int) (stream.header.npositions / BATCHSIZE);
+    ntraining = (int) (nfull * (1.0 - VALIDATION));
+
+    printf("Streaming %"PRIu64" Positions in %"PRIu64" Blocks from %s\n",
+        stream.header.npositions, stream.header.nblocks, TUNER_STREAM);
+
+    if (ntraining < 1) {
+        printf("%s has %d full Blocks, which leaves none for training\n", TUNER_STREAM, nfull);
+        exit(EXIT_FAILURE);
+    }
+
+    split    = malloc(sizeof(int) * stream.header.nblocks);
+    order    = malloc(sizeof(int) * stream.header.nblocks);
+    identity = malloc(sizeof(int) * BATCHSIZE);
+
+    for (int i = 0; i < BATCHSIZE; i++) identity[i] = i;
+
+    // Hold out a random set of full blocks, as well as any partial block
+    for (int i = 0; i < (int) stream.header.nblocks; i++) split[i] = i;
+    if (ntraining != nfull) shuffleTunerOrder(split, nfull, TUNER_SEED);
+
+    // Compute K from a sample of the training blocks, which only needs
+    // the static evaluations and results, but not the Tuples themselves
+    nsample = MIN(STREAMKBLOCKS, ntraining);
+    sample  = malloc(sizeof(TEntry) * nsample * BATCHSIZE);
+
+    for (int i = 0; i < nsample; i++) {
+        entries = readStreamBlock(&stream, split[i], stream.slots[0].buffer);
+        memcpy(&sample[i * BATCHSIZE], entries, sizeof(TEntry) * BATCHSIZE);
+    }
+
+    K = computeOptimalK(sample, nsample * BATCHSIZE);
+    free(sample);
+
+    if (fitOnly) {
+        closeTunerStream(&stream);
+        free(split); free(order); free(identity);
+        return;
+    }
+
+    // Pick up where a previous run left off, or else start fresh
+    if (!loadTunerCheckpoint(&state, layout, dataset)) {
+        state.rate = LRRATE;
+        state.best = 1e9;
+    }
+
+    for (int epoch = state.epoch; epoch < MAXEPOCHS; epoch++) {
+
+        // Each epoch has its own shuffle, so a resumed run sees the same batches
+        memcpy(order, split, sizeof(int) * stream.header.nblocks);
+        if (SHUFFLE) shuffleTunerOrder(order, ntraining, TUNER_SEED + epoch + 1);
+
+        error = 0.0;
+
+        for (int batch = 0; batch < ntraining; batch++) {
+
+            TVector gradient;
+            memset(gradient, 0, sizeof(TVector));
+
+            // Read the next block in the background, while working on the current
+            if (batch == 0) prefetchStreamBlock(&stream, 0, order[0]);
+            entries = awaitStreamBlock(&stream, batch % 2);
+            TTuple *tuples = (TTuple*) (entries + BATCHSIZE);
+
+            if (batch + 1 < ntraining)
+                prefetchStreamBlock(&stream, (batch + 1) % 2, order[batch + 1]);
+
+            // Without a second pass over the data, report a running error
+            error += tunedEvaluationErrors(entries, tuples, identity, BATCHSIZE, state.params, K) / ntraining;
+
+            computeGradient(entries, tuples, identity, BATCHSIZE, gradient, state.params, K);
+            updateParameters(&state, gradient, K);
+        }
+
+        if (ntraining != (int) stream.header.nblocks)
+            validation = streamEvaluationErrors(&stream, order + ntraining,
+                (int) stream.header.nblocks - ntraining, state.params, K);
+
+        if (finishTunerEpoch(&state, cparams, epoch, error, validation,
+                ntraining != (int) stream.header.nblocks, layout, dataset))
+            break;
+    }
+
+    reportTunerBests(&state, cparams);
+    closeTunerStream(&stream);
+    free(split); free(order); free(identity);
+}
+
+uint64_t hashTunerFile(const char *fname) {
+
+    // Hashing the contents of a dataset larger than memory would mean reading
+    // all of it on every start, so settle for the size and modification time
+
+    struct stat info;
+
+    if (stat(fname, &info) == -1) {
+        printf("Unable to open %s\n", fname);
+        exit(EXIT_FAILURE);
+    }
+
+    const uint64_t keys[] = { (uint64_t) info.st_size, (uint64_t) info.st_mtime };
+    return hashTunerBytes(keys, sizeof(keys), 0ull);
+}
+
+void buildTunerStream(Thread *threads, TArray methods, uint64_t layout, uint64_t dataset) {
+
+    int complete = 1;
+    uint64_t length, written = 0, capacity = 1024;
+    TStreamHeader header = {0};
+    TStreamBlock *blocks = malloc(sizeof(TStreamBlock) * capacity);
+
+    TEntry *entries    = malloc(sizeof(TEntry) * BATCHSIZE);
+    TTuple *arena      = malloc(sizeof(TTuple) * BATCHSIZE * MAX(1, NTERMS));
+    const char **lines = malloc(sizeof(char*) * BATCHSIZE);
+
+    int nlines = 0, *order;
+    const char **starts;
+
+    char *data = mapTunerFile("FENS", &length);
+    FILE *fout = fopen(TUNER_STREAM ".tmp", "wb");
+
+    if (data == NULL || fout == NULL) {
+        printf("Unable to convert FENS into %s\n", TUNER_STREAM);
+        exit(EXIT_FAILURE);
+    }
+
+    // Index the start of every line, so that each block can be packed from
+    // lines spread across the entire file, rather than from a single region
+
+    for (const char *curr = data, *end = data + length; curr < end; nlines++) {
+        const char *next = memchr(curr, '\n', end - curr);
+        curr = next ? next + 1 : end;
+    }
+
+    order  = malloc(sizeof(int) * MAX(1, nlines));
+    starts = malloc(sizeof(char*) * MAX(1, nlines));
+    nlines = 0; // Recounted as each start is found
+
+    for (const char *curr = data, *end = data + length; curr < end; nlines++) {
+        const char *next = memchr(curr, '\n', end - curr);
+        starts[nlines] = curr, order[nlines] = nlines;
+        curr = next ? next + 1 : end;
+    }
+
+    shuffleTunerOrder(order, nlines, TUNER_SEED);
+
+    memcpy(header.magic, TUNER_STREAM_MAGIC, sizeof(header.magic));
+    header.version = TUNER_STREAM_VERSION;
+    header.layout  = layout;
+    header.dataset = dataset;
+
+    // The header is rewritten once everything else is known
+    complete = fwrite(&header, sizeof(TStreamHeader), 1, fout) == 1;
+    written += sizeof(TStreamHeader);
+
+    for (int curr = 0; complete && curr < nlines; ) {
+
+        int count = 0;
+        const char *end = data + length;
+
+        // Take the next lines of the shuffled order for this block
+        for (; count < BATCHSIZE && curr < nlines; count++)
+            lines[count] = starts[order[curr++]];
+
+        // Give every entry its own space in the arena, which can never
+        // overflow, since no entry can have more than NTERMS Tuples
+
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (int i = 0; i < count; i++) {
+            TupleStack = &arena[i * NTERMS], TupleStackSize = NTERMS, TupleStackUsed = 0;
+            initTunerFEN(&entries[i], lines[i], end, &threads[omp_get_thread_num()], methods);
+        }
+
+        if (header.nblocks == capacity)
+            blocks = realloc(blocks, sizeof(TStreamBlock) * (capacity *= 2));
+
+        blocks[header.nblocks] = (TStreamBlock) { written, count, 0 };
+
+        // Offsets are relative to the start of the Tuples of each block
+        for (int i = 0; i < count; i++) {
+            entries[i].offset = blocks[header.nblocks].ntuples;
+            blocks[header.nblocks].ntuples += entries[i].ntuples;
+        }
+
+        complete = fwrite(entries, sizeof(TEntry), count, fout) == (size_t) count;
+        written += sizeof(TEntry) * count;
+
+        // Then the tuples of the block, as one contiguous array
+        for (int i = 0; complete && i < count; i++) {
+            complete = fwrite(&arena[i * NTERMS], sizeof(TTuple), entries[i].ntuples, fout) == entries[i].ntuples;
+            written += sizeof(TTuple) * entries[i].ntuples;
+        }
+
+        header.npositions += count;
+        header.ntuples    += blocks[header.nblocks++].ntuples;
+
+        printf("\rConverting FENS into %s [%10"PRIu64" Positions]", TUNER_STREAM, header.npositions);
+    }
+
+    // Finish with the index of blocks, and then the completed header
+    header.index = written;
+    complete = complete
+            && fwrite(blocks, sizeof(TStreamBlock), header.nblocks, fout) == header.nblocks
+            && fseek(fout, 0, SEEK_SET) == 0
+            && fwrite(&header, sizeof(TStreamHeader), 1, fout) == 1
+            && !ferror(fout);
+
+    // Only publish a complete stream, so a short write can never leave a bad one
+    if (fclose(fout) != 0 || !complete || rename(TUNER_STREAM ".tmp", TUNER_STREAM) != 0) {
+        printf("\nUnable to save %s\n", TUNER_STREAM);
+        remove(TUNER_STREAM ".tmp");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("\nSaved %"PRIu64" Entries and %"PRIu64" Tuples to %s\n\n",
+        header.npositions, header.ntuples, TUNER_STREAM);
+
+    unmapTunerFile(data, length);
+    free(blocks); free(entries); free(arena); free(lines);
+    free(order); free(starts);
+}
+
+int openTunerStream(TStream *stream, uint64_t layout, uint64_t dataset) {
+
+    uint64_t largest = 0;
+
+    if ((stream->fin = fopen(TUNER_STREAM, "rb")) == NULL)
+        return 0;
+
+    // Only accept a stream from the same version, layout, and dataset
+    if (   fread(&stream->header, sizeof(TStreamHeader), 1, stream->fin) != 1
+        || memcmp(stream->header.magic, TUNER_STREAM_MAGIC, sizeof(stream->header.magic))
+        || stream->header.version != TUNER_STREAM_VERSION
+        || stream->header.layout  != layout
+        || stream->header.dataset != dataset
+        || stream->header.npositions < BATCHSIZE) {
+        printf("Ignoring the stale %s\n", TUNER_STREAM);
+        fclose(stream->fin);
+        return 0;
+    }
+
+    stream->blocks = malloc(sizeof(TStreamBlock) * stream->header.nblocks);
+
+#if defined(_WIN32) || defined(_WIN64)
+    _fseeki64(stream->fin, stream->header.index, SEEK_SET);
+#else
+    fseeko(stream->fin, stream->header.index, SEEK_SET);
+#endif
+
+    if (fread(stream->blocks, sizeof(TStreamBlock), stream->header.nblocks, stream->fin) != stream->header.nblocks) {
+        printf("Unable to read %s\n", TUNER_STREAM);
+        exit(EXIT_FAILURE);
+    }
+
+    // Both buffers must be able to hold the largest block
+    for (uint64_t i = 0; i < stream->header.nblocks; i++)
+        largest = MAX(largest, stream->blocks[i].nentries * sizeof(TEntry)
+                             + stream->blocks[i].ntuples  * sizeof(TTuple));
+
+    for (int i = 0; i < 2; i++) {
+        stream->slots[i].stream = stream;
+        stream->slots[i].buffer = malloc(largest);
+    }
+
+    return 1;
+}
+
+void closeTunerStream(TStream *stream) {
+    fclose(stream->fin);
+    free(stream->blocks);
+    free(stream->slots[0].buffer);
+    free(stream->slots[1].buffer);
+}
+
+TEntry *readStreamBlock(TStream *stream, int block, char *buffer) {
+
+    TStreamBlock *info = &stream->blocks[block];
+
+    const size_t size = info->nentries * sizeof(TEntry)
+                      + info->ntuples  * sizeof(TTuple);
+
+    // Only one reader is ever active at a time, so the file can be shared
+
+#if defined(_WIN32) || defined(_WIN64)
+    _fseeki64(stream->fin, info->offset, SEEK_SET);
+#else
+    fseeko(stream->fin, info->offset, SEEK_SET);
+#endif
+
+    if (fread(buffer, 1, size, stream->fin) != size) {
+        printf("Unable to read Block %d of %s\n", block, TUNER_STREAM);
+        exit(EXIT_FAILURE);
+    }
+
+    // The Tuples of the block follow directly after the entries
+    return (TEntry*) buffer;
+}
+
+void prefetchStreamBlock(TStream *stream, int slot, int block) {
+    stream->slots[slot].block = block;
+    pthread_create(&stream->slots[slot].reader, NULL, &streamReader, &stream->slots[slot]);
+}
+
+TEntry *awaitStreamBlock(TStream *stream, int slot) {
+    pthread_join(stream->slots[slot].reader, NULL);
+    return (TEntry*) stream->slots[slot].buffer;
+}
+
+double streamEvaluationErrors(TStream *stream, int *order, int length, TVector params, double K) {
+
+    int *identity = malloc(sizeof(int) * BATCHSIZE);
+    double total = 0.0, positions = 0.0;
+
+    for (int i = 0; i < BATCHSIZE; i++) identity[i] = i;
+
+    // Blocks may differ in size, so weight each error by its positions
+    for (int i = 0; i < length; i++) {
+
+        if (i == 0) prefetchStreamBlock(stream, 0, order[0]);
+        TEntry *entries = awaitStreamBlock(stream, i % 2);
+        int count = stream->blocks[order[i]].nentries;
+        TTuple *tuples = (TTuple*) (entries + count);
+
+        if (i + 1 < length)
+            prefetchStreamBlock(stream, (i + 1) % 2, order[i + 1]);
+
+        total     += count * tunedEvaluationErrors(entries, tuples, identity, count, params, K);
+        positions += count;
+    }
+
+    free(identity);
+    return positions ? total / positions : 0.0;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(TUNE)
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "tuner.h"
+#include "types.h"
+
+#define TUNER_STREAM         "FENS.stream" // Batches of Entries and Tuples
+#define TUNER_STREAM_MAGIC   ("ETUNESTR")
+#define TUNER_STREAM_VERSION (3)
+#define STREAMKBLOCKS        (64) // Blocks sampled when computing K
+
+typedef struct TStreamHeader {
+    char magic[8];
+    uint64_t version, layout, dataset;
+    uint64_t npositions, nblocks, ntuples;
+    uint64_t index; // Offset of the TStreamBlock for each block
+} TStreamHeader;
+
+typedef struct TStreamBlock {
+    uint64_t offset;
+    uint32_t nentries, ntuples;
+} TStreamBlock;
+
+typedef struct TStreamSlot {
+    struct TStream *stream;
+    pthread_t reader;
+    int block;
+    char *buffer;
+} TStreamSlot;
+
+typedef struct TStream {
+    FILE *fin;
+    TStreamHeader header;
+    TStreamBlock *blocks;
+    TStreamSlot slots[2];
+} TStream;
+
+void runStreamingTuner(Thread *threads, TVector cparams, TArray methods, int fitOnly);
+uint64_t hashTunerFile(const char *fname);
+void buildTunerStream(Thread *threads, TArray methods, uint64_t layout, uint64_t dataset);
+int openTunerStream(TStream *stream, uint64_t layout, uint64_t dataset);
+void closeTunerStream(TStream *stream);
+TEntry *readStreamBlock(TStream *stream, int block, char *buffer);
+void prefetchStreamBlock(TStream *stream, int slot, int block);
+TEntry *awaitStreamBlock(TStream *stream, int slot);
+double streamEvaluationErrors(TStream *stream, int *order, int length, TVector params, double K);
+
+#endif
@@ -91,6 +91,14 @@ typedef struct PKEntry PKEntry;
 typedef struct TTable TTable;
 typedef struct Limits Limits;
 typedef struct UCIGoStruct UCIGoStruct;
+typedef struct EvalBook EvalBook;
+typedef struct EvalBookResult EvalBookResult;
+typedef struct PerfCounters PerfCounters;
+typedef struct TraceEvent TraceEvent;
+typedef struct SearchTrace SearchTrace;
+typedef struct DataGen DataGen;
+typedef struct DataQuiet DataQuiet;
+typedef struct TBPreload TBPreload;
 
 // Renamings, currently for move ordering
 
@@ -104,3 +112,7 @@ typedef int16_t CaptureHistoryTable[PIECE_NB][SQUARE_NB][PIECE_NB-1];
 // Trivial alignment macros
 
 #define ALIGN64 alignas(64)
+
+// Force inlining for bodies which are specialized by constant arguments
+
+#define INLINE inline __attribute__((always_inline))
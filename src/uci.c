@@ -26,6 +26,7 @@
 #include "attacks.h"
 #include "board.h"
 #include "cmdline.h"
+#include "cpu.h"
 #include "evaluate.h"
 #include "pyrrhic/tbprobe.h"
 #include "history.h"
@@ -34,6 +35,8 @@
 #include "movegen.h"
 
 #include "search.h"
+#include "searchtrace.h"
+#include "syzygy.h"
 #include "thread.h"
 #include "time.h"
 #include "transposition.h"
@@ -49,6 +52,10 @@ extern volatile int ABORT_SIGNAL; // Defined by search.c
 extern volatile int IS_PONDERING; // Defined by search.c
 extern volatile int ANALYSISMODE; // Defined by search.c
 
+int Telemetry;       // Set by UCI options, emits per-thread statistics
+int SearchTraceSize; // Set by UCI options, megabytes of Search Trace per thread
+int Deterministic;   // Set by UCI options, resets all search state before each go
+
 pthread_mutex_t READYLOCK = PTHREAD_MUTEX_INITIALIZER;
 const char *StartPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
@@ -64,7 +71,7 @@ int main(int argc, char **argv) {
     int multiPV  = 1;
 
     // Initialize core components of Ethereal
-    initAttacks(); initMasks(); initEval();
+    initCPU(); initAttacks(); initMasks(); initEval();
     initSearch(); initZobrist(); initTT(16);
 
     // Create the UCI-board and our threads
@@ -89,14 +96,17 @@ int main(int argc, char **argv) {
     |       quit |             Exits the engine and any searches by killing the UCI loop |
     |      perft |            Custom command to compute PERFT(N) of the current position |
     |      print |         Custom command to print an ASCII view of the current position |
+    |      stats |      Custom command to print per-thread search and caching statistics |
+    |      trace | *   Custom command to dump each thread's Search Trace to a given file |
     |------------|-----------------------------------------------------------------------|
     */
 
     while (getInput(str)) {
 
         if (strEquals(str, "uci")) {
-            printf("id name Ethereal " ETHEREAL_VERSION "\n");
+            printf("id name Ethereal " VERSION_ID "%s\n", cpuPathName());
             printf("id author Andrew Grant, Alayan & Laldon\n");
+            reportCPU();
             printf("option name Hash type spin default 16 min 2 max 131072\n");
             printf("option name Threads type spin default 1 min 1 max 2048\n");
             printf("option name MultiPV type spin default 1 min 1 max 256\n");
@@ -105,8 +115,12 @@ int main(int argc, char **argv) {
             printf("option name MoveOverhead type spin default 100 min 0 max 10000\n");
             printf("option name SyzygyPath type string default <empty>\n");
             printf("option name SyzygyProbeDepth type spin default 0 min 0 max 127\n");
+            printf("option name SyzygyPreload type string default <empty>\n");
             printf("option name Ponder type check default false\n");
             printf("option name AnalysisMode type check default false\n");
+            printf("option name Telemetry type check default false\n");
+            printf("option name SearchTrace type spin default 0 min 0 max 4096\n");
+            printf("option name Deterministic type check default false\n");
             printf("option name UCI_Chess960 type check default false\n");
             printf("uciok\n"), fflush(stdout);
         }
@@ -159,6 +173,18 @@ int main(int argc, char **argv) {
 
         else if (strStartsWith(str, "print"))
             printBoard(&board), fflush(stdout);
+
+        else if (strEquals(str, "stats"))
+            uciReportTelemetry(threads);
+
+        else if (strStartsWith(str, "trace ")) {
+            pthread_mutex_lock(&READYLOCK);
+            if (dumpSearchTrace(threads, str + strlen("trace ")))
+                printf("info string dumped SearchTrace to %s\n", str + strlen("trace "));
+            else printf("info string unable to dump SearchTrace to %s\n", str + strlen("trace "));
+            fflush(stdout);
+            pthread_mutex_unlock(&READYLOCK);
+        }
     }
 
     return 0;
@@ -174,6 +200,7 @@ void *uciGo(void *cargo) {
     char moveStr[6];
 
     int depth = 0, infinite = 0;
+    uint64_t nodes = 0ull;
     double wtime = 0, btime = 0, movetime = 0;
     double winc = 0, binc = 0, mtg = -1;
 
@@ -202,6 +229,7 @@ void *uciGo(void *cargo) {
         if (strEquals(ptr, "movestogo"  )) mtg      = atoi(strtok(NULL, " "));
         if (strEquals(ptr, "depth"      )) depth    = atoi(strtok(NULL, " "));
         if (strEquals(ptr, "movetime"   )) movetime = atoi(strtok(NULL, " "));
+        if (strEquals(ptr, "nodes"      )) nodes    = strtoull(strtok(NULL, " "), NULL, 10);
 
         if (strEquals(ptr, "infinite"   )) infinite = 1;
         if (strEquals(ptr, "searchmoves")) searchmoves = 1;
@@ -217,10 +245,12 @@ void *uciGo(void *cargo) {
     limits.limitedByNone  = infinite != 0;
     limits.limitedByTime  = movetime != 0;
     limits.limitedByDepth = depth    != 0;
-    limits.limitedBySelf  = !depth && !movetime && !infinite;
+    limits.limitedByNodes = nodes    != 0;
+    limits.limitedBySelf  = !depth && !movetime && !infinite && !nodes;
     limits.limitedByMoves = searchmoves;
     limits.timeLimit      = movetime;
     limits.depthLimit     = depth;
+    limits.nodeLimit      = nodes;
 
     // Pick the time values for the colour we are playing as
     limits.start = (board->turn == WHITE) ? start : start;
@@ -231,6 +261,10 @@ void *uciGo(void *cargo) {
     // Cap our MultiPV search based on the suggested or legal moves
     limits.multiPV = MIN(multiPV, searchmoves ? idx : size);
 
+    // Searches are only reproducible from a known state. Given a
+    // single thread, node counts are then identical run to run
+    if (Deterministic) resetThreadPool(threads), clearTT();
+
     // Execute search, return best and ponder moves
     getBestMove(threads, board, &limits, &bestMove, &ponderMove);
 
@@ -267,6 +301,10 @@ void uciSetOption(char *str, Thread **threads, int *multiPV, int *chess960) {
     //  MoveOverhead        : Overhead on time allocation to avoid time losses
     //  SyzygyPath          : Path to Syzygy Tablebases
     //  SyzygyProbeDepth    : Minimal Depth to probe the highest cardinality Tablebase
+    //  SyzygyPreload       : Max pieces, or a list of tables, to load into memory in the background
+    //  Telemetry           : Report per-thread statistics alongside each search report
+    //  SearchTrace         : Megabytes per thread to record recent search nodes into
+    //  Deterministic       : Clear the TT and per-thread tables before each search
     //  UCI_Chess960        : Set when playing FRC, but not required in order to work
 
     if (strStartsWith(str, "setoption name Hash value ")) {
@@ -276,7 +314,8 @@ void uciSetOption(char *str, Thread **threads, int *multiPV, int *chess960) {
 
     if (strStartsWith(str, "setoption name Threads value ")) {
         int nthreads = atoi(str + strlen("setoption name Threads value "));
-        free(*threads); *threads = createThreadPool(nthreads);
+        deleteThreadPool(*threads); *threads = createThreadPool(nthreads);
+        resizeSearchTrace(*threads, SearchTraceSize);
         printf("info string set Threads to %d\n", nthreads);
     }
 
@@ -302,7 +341,7 @@ void uciSetOption(char *str, Thread **threads, int *multiPV, int *chess960) {
 
     if (strStartsWith(str, "setoption name SyzygyPath value ")) {
         char *ptr = str + strlen("setoption name SyzygyPath value ");
-        tb_init(ptr); printf("info string set SyzygyPath to %s\n", ptr);
+        tablebasesSetPath(ptr); printf("info string set SyzygyPath to %s\n", ptr);
     }
 
     if (strStartsWith(str, "setoption name SyzygyProbeDepth value ")) {
@@ -310,6 +349,12 @@ void uciSetOption(char *str, Thread **threads, int *multiPV, int *chess960) {
         printf("info string set SyzygyProbeDepth to %u\n", TB_PROBE_DEPTH);
     }
 
+    if (strStartsWith(str, "setoption name SyzygyPreload value ")) {
+        char *ptr = str + strlen("setoption name SyzygyPreload value ");
+        tablebasesSetPreload(strEquals(ptr, "<empty>") ? "" : ptr);
+        printf("info string set SyzygyPreload to %s\n", ptr);
+    }
+
     if (strStartsWith(str, "setoption name AnalysisMode value ")) {
         if (strStartsWith(str, "setoption name AnalysisMode value true"))
             printf("info string set AnalysisMode to true\n"), ANALYSISMODE = 1;
@@ -317,6 +362,26 @@ void uciSetOption(char *str, Thread **threads, int *multiPV, int *chess960) {
             printf("info string set AnalysisMode to false\n"), ANALYSISMODE = 0;
     }
 
+    if (strStartsWith(str, "setoption name Telemetry value ")) {
+        if (strStartsWith(str, "setoption name Telemetry value true"))
+            printf("info string set Telemetry to true\n"), Telemetry = 1;
+        if (strStartsWith(str, "setoption name Telemetry value false"))
+            printf("info string set Telemetry to false\n"), Telemetry = 0;
+    }
+
+    if (strStartsWith(str, "setoption name SearchTrace value ")) {
+        SearchTraceSize = atoi(str + strlen("setoption name SearchTrace value "));
+        resizeSearchTrace(*threads, SearchTraceSize);
+        printf("info string set SearchTrace to %dMB\n", SearchTraceSize);
+    }
+
+    if (strStartsWith(str, "setoption name Deterministic value ")) {
+        if (strStartsWith(str, "setoption name Deterministic value true"))
+            printf("info string set Deterministic to true\n"), Deterministic = 1;
+        if (strStartsWith(str, "setoption name Deterministic value false"))
+            printf("info string set Deterministic to false\n"), Deterministic = 0;
+    }
+
     if (strStartsWith(str, "setoption name UCI_Chess960 value ")) {
         if (strStartsWith(str, "setoption name UCI_Chess960 value true"))
             printf("info string set UCI_Chess960 to true\n"), *chess960 = 1;
@@ -418,6 +483,31 @@ void uciReport(Thread *threads, int alpha, int beta, int value) {
 
     // Send out a newline and flush
     puts(""); fflush(stdout);
+
+    // Follow up with the per-thread breakdown when requested
+    if (Telemetry) uciReportTelemetry(threads);
+}
+
+void uciReportTelemetry(Thread *threads) {
+
+    // Report the statistics of each Thread on its own line. The counters are
+    // only ever written by their owning Thread, and live on their own cache
+    // line, so reading them here while searching is cheap but may be stale
+
+    for (int i = 0; i < threads->nthreads; i++) {
+
+        const Thread *thread = &threads[i];
+
+        printf("info string thread %d depth %d seldepth %d nodes %"PRIu64" tbhits %"PRIu64
+               " tthit %.1f%% evalhit %.1f%% pkhit %.1f%% wdlhit %.1f%%\n",
+               i, thread->depth, thread->seldepth, thread->nodes, thread->tbhits,
+               100.0 * thread->tthits / MAX(1ull, thread->ttprobes),
+               100.0 * thread->evhits / MAX(1ull, thread->evprobes),
+               100.0 * thread->pkhits / MAX(1ull, thread->pkprobes),
+               100.0 * thread->wdlhits / MAX(1ull, thread->wdlprobes));
+    }
+
+    fflush(stdout);
 }
 
 void uciReportCurrentMove(Board *board, uint16_t move, int currmove, int depth) {
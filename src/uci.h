@@ -24,18 +24,12 @@
 
 #define VERSION_ID "12.87"
 
-#if defined(USE_PEXT)
-    #define ETHEREAL_VERSION VERSION_ID" (PEXT)"
-#elif defined(USE_POPCNT)
-    #define ETHEREAL_VERSION VERSION_ID" (POPCNT)"
-#else
-    #define ETHEREAL_VERSION VERSION_ID
-#endif
-
 struct Limits {
     double start, time, inc, mtg, timeLimit;
     int limitedByNone, limitedByTime, limitedBySelf;
     int limitedByDepth, limitedByMoves, depthLimit, multiPV;
+    int limitedByNodes, silent;
+    uint64_t nodeLimit;
     uint16_t searchMoves[MAX_MOVES], excludedMoves[MAX_MOVES];
 };
 
@@ -51,6 +45,7 @@ void uciSetOption(char *str, Thread **threads, int *multiPV, int *chess960);
 void uciPosition(char *str, Board *board, int chess960);
 
 void uciReport(Thread *threads, int alpha, int beta, int value);
+void uciReportTelemetry(Thread *threads);
 void uciReportCurrentMove(Board *board, uint16_t move, int currmove, int depth);
 
 int strEquals(char *str1, char *str2);
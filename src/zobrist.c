@@ -16,8 +16,12 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <assert.h>
 #include <stdint.h>
 
+#include "attacks.h"
+#include "bitboards.h"
+#include "move.h"
 #include "types.h"
 #include "zobrist.h"
 
@@ -26,6 +30,9 @@ uint64_t ZobristEnpassKeys[FILE_NB];
 uint64_t ZobristCastleKeys[SQUARE_NB];
 uint64_t ZobristTurnKey;
 
+uint64_t CuckooKeys[CUCKOO_SIZE];
+uint16_t CuckooMoves[CUCKOO_SIZE];
+
 uint64_t rand64() {
 
     // http://vigna.di.unimi.it/ftp/papers/xorshift.pdf
@@ -57,4 +64,65 @@ void initZobrist() {
 
     // Init the Zobrist key for side to move
     ZobristTurnKey = rand64();
+
+    // Index every reversible move by the change it makes to the hash
+    initCuckoo();
+}
+
+void initCuckoo() {
+
+    // Build a Cuckoo table of every reversible move, indexed by the hash
+    // difference between the positions before and after the move. Moving
+    // a piece from sq1 to sq2 and back produces the same key, so only one
+    // direction is stored. Requires that initAttacks() has been called
+
+    int count = 0;
+
+    for (int sq = 0; sq < CUCKOO_SIZE; sq++)
+        CuckooKeys[sq] = 0ull, CuckooMoves[sq] = NONE_MOVE;
+
+    for (int colour = WHITE; colour <= BLACK; colour++) {
+        for (int piece = KNIGHT; piece <= KING; piece++) {
+            for (int sq1 = 0; sq1 < SQUARE_NB; sq1++) {
+
+                uint64_t attacks = piece == KNIGHT ? knightAttacks(sq1)
+                                 : piece == BISHOP ? bishopAttacks(sq1, 0ull)
+                                 : piece == ROOK   ? rookAttacks(sq1, 0ull)
+                                 : piece == QUEEN  ? queenAttacks(sq1, 0ull)
+                                 :                   kingAttacks(sq1);
+
+                for (int sq2 = sq1 + 1; sq2 < SQUARE_NB; sq2++) {
+
+                    if (!testBit(attacks, sq2)) continue;
+
+                    uint64_t key = ZobristKeys[makePiece(piece, colour)][sq1]
+                                 ^ ZobristKeys[makePiece(piece, colour)][sq2]
+                                 ^ ZobristTurnKey;
+                    uint16_t move = MoveMake(sq1, sq2, NORMAL_MOVE);
+
+                    // Insert, displacing any occupant into its other slot
+                    // until every entry has found an empty home
+                    unsigned index = CuckooHash1(key);
+
+                    while (1) {
+
+                        uint64_t tempKey = CuckooKeys[index];
+                        uint16_t tempMove = CuckooMoves[index];
+                        CuckooKeys[index] = key, CuckooMoves[index] = move;
+                        key = tempKey, move = tempMove;
+
+                        if (move == NONE_MOVE) break;
+
+                        index = index == CuckooHash1(key)
+                              ? CuckooHash2(key) : CuckooHash1(key);
+                    }
+
+                    count++;
+                }
+            }
+        }
+    }
+
+    // 3668 = 2 * (168 + 280 + 448 + 728 + 210)
+    assert(count == 3668); (void) count;
 }
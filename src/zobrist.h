@@ -22,10 +22,22 @@
 
 #include "types.h"
 
+enum {
+    CUCKOO_SIZE = 8192,
+    CUCKOO_MASK = CUCKOO_SIZE - 1,
+};
+
+#define CuckooHash1(key) (((key) >>  0) & CUCKOO_MASK)
+#define CuckooHash2(key) (((key) >> 16) & CUCKOO_MASK)
+
 extern uint64_t ZobristKeys[32][SQUARE_NB];
 extern uint64_t ZobristEnpassKeys[FILE_NB];
 extern uint64_t ZobristCastleKeys[SQUARE_NB];
 extern uint64_t ZobristTurnKey;
 
+extern uint64_t CuckooKeys[CUCKOO_SIZE];
+extern uint16_t CuckooMoves[CUCKOO_SIZE];
+
 uint64_t rand64();
 void initZobrist();
+void initCuckoo();